@@ -0,0 +1,49 @@
+TEMPLATE = app
+TARGET = xppBenchmark
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += thread
+
+INCLUDEPATH += $$PWD/..
+
+include(../parser/muparserx/muparserx.pri)
+
+HEADERS +=	xppModelGenerator.h \
+		../parser/keywordTrie.hpp \
+		../parser/xppCompactModel.h \
+		../parser/xppEvaluator.h \
+		../parser/xppHash.h \
+		../parser/xppIndexExpression.h \
+		../parser/xppLineText.h \
+		../parser/xppMappedFile.h \
+		../parser/xppModelCache.h \
+		../parser/xppParser.h \
+		../parser/xppParserDefines.h \
+		../parser/xppParserException.h \
+		../parser/xppParserStats.h \
+		../parser/xppPerfectHash.h \
+		../parser/xppStructuralIndex.h \
+		../parser/xppSymbolTable.h \
+		../parser/xppTableExpression.h \
+		../parser/xppTableFile.h
+
+SOURCES +=	main.cpp \
+		xppModelGenerator.cpp \
+		../parser/xppCompactModel.cpp \
+		../parser/xppEvaluator.cpp \
+		../parser/xppIndexExpression.cpp \
+		../parser/xppLineText.cpp \
+		../parser/xppMappedFile.cpp \
+		../parser/xppModelCache.cpp \
+		../parser/xppParser.cpp \
+		../parser/xppParserStats.cpp \
+		../parser/xppStructuralIndex.cpp \
+		../parser/xppSymbolTable.cpp \
+		../parser/xppTableExpression.cpp \
+		../parser/xppTableFile.cpp
+
+QMAKE_CXXFLAGS += -std=c++14
+QMAKE_CXXFLAGS_RELEASE -= -O1
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE *= -O3
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/xppModelGenerator.h"
+#include "parser/compactTrie.hpp"
+#include "parser/xppEvaluator.h"
+#include "parser/xppParser.h"
+
+namespace {
+
+typedef std::chrono::steady_clock benchmarkClock;
+
+/* Timing of a single model */
+struct benchmarkResult {
+    std::size_t	lines			= 0;
+    std::size_t	bytes			= 0;
+    double		parseSeconds	= 0.0;
+    double		evaluateSeconds	= 0.0;
+    std::string	error;
+};
+
+/**
+ * @brief seconds Returns the seconds since a point in time
+ */
+double seconds(benchmarkClock::time_point start) {
+    return std::chrono::duration<double>(benchmarkClock::now() - start).count();
+}
+
+/**
+ * @brief parseSizes Parses a comma separated list of line counts
+ */
+std::vector<std::size_t> parseSizes(const std::string &list) {
+    std::vector<std::size_t> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        sizes.push_back(static_cast<std::size_t>(std::stod(item)));
+    }
+    return sizes;
+}
+
+/**
+ * @brief runModel Parses and evaluates a single model
+ *
+ * The parser reports errors on the standard error stream and the evaluator
+ * its summary on the standard output, so both are captured while the model
+ * is timed.
+ */
+benchmarkResult runModel(const std::string &fn, const xppParserConfig &config,
+                         bool evaluate) {
+    benchmarkResult result;
+    std::stringstream errors;
+    std::streambuf *errorBuffer	 = std::cerr.rdbuf(errors.rdbuf());
+    std::streambuf *outputBuffer = std::cout.rdbuf(nullptr);
+
+    benchmarkClock::time_point start = benchmarkClock::now();
+    xppParser parser(fn, config);
+    result.parseSeconds = seconds(start);
+
+    if (evaluate && errors.str().empty()) {
+        start = benchmarkClock::now();
+        xppEvaluator evaluator(std::move(parser));
+        result.evaluateSeconds = seconds(start);
+    }
+
+    std::cout.rdbuf(outputBuffer);
+    std::cout.clear();
+    std::cerr.rdbuf(errorBuffer);
+    result.error = errors.str();
+    return result;
+}
+
+/**
+ * @brief runUpdates Times an edit-then-update loop on a single model
+ *
+ * The model is parsed once in incremental mode. Then the value of a parameter
+ * is changed and the file is written again, as an editor would, before the
+ * parser is updated. The parameter lines are edited in turn. Writing the file
+ * is not part of the timing.
+ *
+ * @return The initial parse in parseSeconds and the mean update in
+ * evaluateSeconds
+ */
+benchmarkResult runUpdates(const std::string &fn, xppParserConfig config,
+                           unsigned edits) {
+    benchmarkResult result;
+    std::string content;
+    {
+        std::ifstream file(fn.c_str(), std::ios::in | std::ios::binary);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        content = stream.str();
+    }
+    std::vector<std::size_t> values;
+    for (std::size_t pos = content.find("\npar "); pos != std::string::npos;
+         pos = content.find("\npar ", pos + 1)) {
+        values.push_back(content.find('=', pos) + 1);
+    }
+    if (values.empty()) {
+        result.error = "No parameter to edit\n";
+        return result;
+    }
+
+    std::stringstream errors;
+    std::streambuf *errorBuffer = std::cerr.rdbuf(errors.rdbuf());
+    config.incremental = true;
+    benchmarkClock::time_point start = benchmarkClock::now();
+    xppParser parser(fn, config);
+    result.parseSeconds = seconds(start);
+
+    double total = 0.0;
+    for (unsigned edit = 0; edit < edits && errors.str().empty(); ++edit) {
+        char &digit = content[values[edit % values.size()]];
+        digit = digit == '9' ? '1' : digit + 1;
+        {
+            std::ofstream file(fn.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            file << content;
+        }
+        start = benchmarkClock::now();
+        parser.update();
+        total += seconds(start);
+    }
+    result.evaluateSeconds = total / std::max(edits, 1u);
+
+    std::cerr.rdbuf(errorBuffer);
+    result.error = errors.str();
+    return result;
+}
+
+/**
+ * @brief runTries Compares the keyword trie and the compact trie on a
+ * dictionary of generated variable names
+ *
+ * Both tries are built one key at a time and finished as the evaluator does,
+ * the keyword trie by compile() and the compact trie by build(). Then they
+ * search the same expressions, whose matches have to agree. One line of comma
+ * separated values is written per trie.
+ *
+ * @return False if the matches differ
+ */
+bool runTries(std::size_t keywords) {
+    std::vector<std::string> names;
+    names.reserve(keywords);
+    for (std::size_t i = 0; i < keywords; ++i) {
+        names.push_back((i % 2 ? "x" : "par") + std::to_string(i));
+    }
+    std::mt19937 random(2017);
+    std::uniform_int_distribution<std::size_t> pick(0, keywords - 1);
+    std::vector<std::string> texts(10000);
+    for (std::string &text : texts) {
+        for (unsigned k = 0; k < 8; ++k) {
+            text += (k ? "+" : "") + names[pick(random)] + "*t";
+        }
+    }
+
+    std::cout << "keywords,trie,build_seconds,search_seconds,bytes,matches" << std::endl;
+    std::vector<keywordTrie::matchCollection> results[2];
+    auto measure = [&](const char *label, auto &trie, auto finish,
+                       std::vector<keywordTrie::matchCollection> &found) {
+        benchmarkClock::time_point start = benchmarkClock::now();
+        for (const std::string &name : names) {
+            trie.addString(name);
+        }
+        finish(trie);
+        const double build = seconds(start);
+        start = benchmarkClock::now();
+        std::size_t count = 0;
+        found.resize(texts.size());
+        for (std::size_t i = 0; i < texts.size(); ++i) {
+            trie.parseText(texts[i], found[i]);
+            count += found[i].size();
+        }
+        const double search = seconds(start);
+        std::cout << keywords << "," << label << "," << build << "," << search << ","
+                  << trie.memoryUsage() << "," << count << std::endl;
+    };
+    {
+        keywordTrie::trie trie;
+        measure("trie", trie, [](keywordTrie::trie &t) {t.compile();}, results[0]);
+    }
+    {
+        keywordTrie::compactTrie trie;
+        measure("compactTrie", trie, [](keywordTrie::compactTrie &t) {t.build();},
+                results[1]);
+    }
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+        if (results[0][i].size() != results[1][i].size() ||
+            !std::equal(results[0][i].begin(), results[0][i].end(), results[1][i].begin(),
+                        [](const keywordTrie::match &a, const keywordTrie::match &b) {
+                            return a.id == b.id && a.start == b.start && a.end == b.end;
+                        })) {
+            std::cerr << "The tries differ on expression " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief printUsage Prints the command line options
+ */
+void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --sizes n1,n2,...  Line counts of the models (default 1e3,1e4,1e5,1e6,1e7)\n"
+              << "  --repeat n         Runs per model, the fastest is reported (default 3)\n"
+              << "  -j n               Threads of the parser (default 1)\n"
+              << "  --dir path         Directory for the generated models (default .)\n"
+              << "  --parse-only       Do not run the evaluator\n"
+              << "  --update n         Time n edits of a parameter, each followed by an\n"
+              << "                     incremental update, instead of the evaluator\n"
+              << "  --keep             Keep the generated models\n"
+              << "  --generate n file  Only write a model of n lines\n"
+              << "  --tries n          Only compare the tries on a dictionary of n names\n";
+}
+
+} // namespace
+
+/* Benchmark of the parser on synthetic models of increasing size. For every
+ * size a model is generated, parsed and evaluated, and one line of comma
+ * separated values is written to the standard output.
+ */
+int main(int argc, char** argv)
+{
+    std::vector<std::size_t> sizes = {1000, 10000, 100000, 1000000, 10000000};
+    std::string directory = ".";
+    unsigned repeat = 3;
+    unsigned edits = 0;
+    bool evaluate = true;
+    bool keep = false;
+    xppParserConfig config;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg(argv[i]);
+            if (arg == "--sizes" && i+1 < argc) {
+                sizes = parseSizes(argv[++i]);
+            } else if (arg == "--repeat" && i+1 < argc) {
+                repeat = std::max(1u, static_cast<unsigned>(std::stoul(argv[++i])));
+            } else if (arg == "-j" && i+1 < argc) {
+                config.threads = std::stoul(argv[++i]);
+            } else if (arg == "--dir" && i+1 < argc) {
+                directory = argv[++i];
+            } else if (arg == "--parse-only") {
+                evaluate = false;
+            } else if (arg == "--update" && i+1 < argc) {
+                edits = std::max(1u, static_cast<unsigned>(std::stoul(argv[++i])));
+            } else if (arg == "--keep") {
+                keep = true;
+            } else if (arg == "--generate" && i+2 < argc) {
+                const std::size_t lines = static_cast<std::size_t>(std::stod(argv[i+1]));
+                xppModelGenerator::write(xppModelSpec::forLines(lines), argv[i+2]);
+                return 0;
+            } else if (arg == "--tries" && i+1 < argc) {
+                const std::size_t keywords = static_cast<std::size_t>(std::stod(argv[++i]));
+                return runTries(std::max<std::size_t>(keywords, 1)) ? 0 : 1;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+    if (edits > 0) {
+        std::cout << "lines,bytes,threads,parse_seconds,update_seconds,"
+                     "parse_ns_per_line,update_ns_per_line" << std::endl;
+    } else {
+        std::cout << "lines,bytes,threads,parse_seconds,evaluate_seconds,"
+                     "parse_ns_per_line,evaluate_ns_per_line" << std::endl;
+    }
+    for (const std::size_t size : sizes) {
+        const std::string fn = directory + "/xppBenchmark_" + std::to_string(size) + ".ode";
+        benchmarkResult best;
+        try {
+            best.lines = xppModelGenerator::write(xppModelSpec::forLines(size), fn);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        for (unsigned run = 0; run < repeat; ++run) {
+            const benchmarkResult result = edits > 0 ? runUpdates(fn, config, edits)
+                                                     : runModel(fn, config, evaluate);
+            if (!result.error.empty()) {
+                best.error = result.error;
+                break;
+            }
+            if (run == 0 || result.parseSeconds < best.parseSeconds) {
+                best.parseSeconds = result.parseSeconds;
+            }
+            if (run == 0 || result.evaluateSeconds < best.evaluateSeconds) {
+                best.evaluateSeconds = result.evaluateSeconds;
+            }
+        }
+        std::ifstream file(fn.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+        best.bytes = static_cast<std::size_t>(file.tellg());
+        file.close();
+        if (!keep) {
+            std::remove(fn.c_str());
+        }
+
+        if (!best.error.empty()) {
+            std::cerr << fn << ": " << best.error;
+            status = 1;
+            continue;
+        }
+        std::cout << best.lines << "," << best.bytes << "," << config.threads << ","
+                  << best.parseSeconds << "," << best.evaluateSeconds << ","
+                  << 1.0e9*best.parseSeconds/best.lines << ","
+                  << 1.0e9*best.evaluateSeconds/best.lines << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,150 @@
+#include "xppModelGenerator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+/* Number of names that are declared by a single par or init statement */
+const std::size_t namesPerLine = 10;
+
+/**
+ * @brief writeList Writes a statement that declares a list of names
+ * @return The number of lines written.
+ */
+template<typename Value>
+std::size_t writeList(std::ostream &stream, const char *keyword,
+                      const char *prefix, std::size_t count, Value value) {
+    std::size_t lines = 0;
+    for (std::size_t first = 0; first < count; first += namesPerLine) {
+        stream << keyword;
+        const std::size_t last = std::min(count, first + namesPerLine);
+        for (std::size_t i = first; i < last; ++i) {
+            stream << (i == first ? " " : ", ") << prefix << i << "=" << value(i);
+        }
+        stream << "\n";
+        ++lines;
+    }
+    return lines;
+}
+
+} // namespace
+
+/**
+ * @brief xppModelSpec::forLines Returns a model of roughly the given number
+ * of lines
+ *
+ * Most lines are equations. The remaining statements grow proportionally, so
+ * that every phase of the parser is scaled alike.
+ */
+xppModelSpec xppModelSpec::forLines(std::size_t lines) {
+    xppModelSpec spec;
+    spec.equations	= std::max<std::size_t>(1, lines*7/10);
+    spec.arrays		= lines/100;
+    spec.tables		= lines/500;
+    spec.markovs	= lines/500;
+    spec.functions	= lines/100;
+    spec.constants	= lines/100;
+    return spec;
+}
+
+/**
+ * @brief xppModelGenerator::write Writes a synthetic ode file to a stream
+ * @param spec The composition of the model.
+ * @param stream The target stream.
+ * @return The number of lines written.
+ */
+std::size_t xppModelGenerator::write(const xppModelSpec &spec, std::ostream &stream) {
+    std::size_t lines = 1;
+    stream << "# Synthetic model with " << spec.equations << " equations\n";
+
+    /* Constants and parameters */
+    for (std::size_t i = 0; i < spec.constants; ++i) {
+        stream << "!c" << i << "=" << i % 7 + 1 << "\n";
+    }
+    lines += spec.constants;
+    lines += writeList(stream, "par", "p", spec.equations,
+                       [](std::size_t i) {return 0.5 + i % 10;});
+
+    /* Chains of functions, every one calls the previous one */
+    for (std::size_t i = 0; i < spec.functions; ++i) {
+        stream << "f" << i << "_0(a,b)=a*b+" << i % 5 + 1 << "\n";
+        for (unsigned depth = 1; depth < spec.functionDepth; ++depth) {
+            stream << "f" << i << "_" << depth << "(a,b)=f" << i << "_"
+                   << depth-1 << "(a,b)*2+a\n";
+        }
+        lines += std::max(spec.functionDepth, 1u);
+    }
+
+    /* Equations that are coupled to their neighbour */
+    for (std::size_t i = 0; i < spec.equations; ++i) {
+        stream << "x" << i << "'=-x" << i << "+p" << i << "*x"
+               << (i+1) % spec.equations;
+        if (spec.constants > 0) {
+            stream << "*c" << i % spec.constants;
+        }
+        stream << "\n";
+    }
+    lines += spec.equations;
+    lines += writeList(stream, "init", "x", spec.equations,
+                       [](std::size_t i) {return 0.1*(i % 10);});
+
+    /* Auxiliary variables that call the last function of every chain */
+    for (std::size_t i = 0; i < spec.functions && spec.equations > 1; ++i) {
+        stream << "aux g" << i << "=f" << i << "_"
+               << std::max(spec.functionDepth, 1u) - 1 << "(x0,x1)\n";
+        ++lines;
+    }
+
+    /* Array blocks of a chain of coupled variables */
+    for (std::size_t i = 0; i < spec.arrays; ++i) {
+        stream << "%[1.." << spec.arraySize << "]\n"
+               << "u" << i << "[j]'=-u" << i << "[j]+v" << i << "[j]*[j]\n"
+               << "v" << i << "[j]'=u" << i << "[j]-v" << i << "[j]\n"
+               << "%\n";
+        lines += 4;
+    }
+
+    /* Computed tables */
+    for (std::size_t i = 0; i < spec.tables; ++i) {
+        stream << "table tb" << i << " % " << spec.tablePoints
+               << " 0 6.283 sin(t)+" << i % 3 << "*cos(2*t)\n";
+        ++lines;
+    }
+
+    /* Markov processes with a full transition matrix */
+    for (std::size_t i = 0; i < spec.markovs; ++i) {
+        stream << "markov m" << i << " " << spec.markovStates << "\n";
+        for (unsigned row = 0; row < spec.markovStates; ++row) {
+            for (unsigned col = 0; col < spec.markovStates; ++col) {
+                stream << (col == 0 ? "" : " ") << "{"
+                       << (row == col ? "0" : "0.1*x0") << "}";
+            }
+            stream << "\n";
+        }
+        lines += 1 + spec.markovStates;
+    }
+
+    stream << "@ total=100,dt=0.01,meth=rungekutta\n"
+           << "done\n";
+    return lines + 2;
+}
+
+/**
+ * @brief xppModelGenerator::write Writes a synthetic ode file
+ * @param spec The composition of the model.
+ * @param fn The name of the file.
+ * @return The number of lines written.
+ */
+std::size_t xppModelGenerator::write(const xppModelSpec &spec, const std::string &fn) {
+    std::ofstream stream(fn.c_str(), std::ios::out | std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error("Cannot write model " + fn);
+    }
+    const std::size_t lines = write(spec, stream);
+    if (!stream) {
+        throw std::runtime_error("Cannot write model " + fn);
+    }
+    return lines;
+}
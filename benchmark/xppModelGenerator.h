@@ -0,0 +1,48 @@
+#ifndef XPPMODELGENERATOR_H
+#define XPPMODELGENERATOR_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+/* Composition of a synthetic ode file */
+struct xppModelSpec {
+    /* Number of differential equations, each with its own parameter and
+     * initial condition
+     */
+    std::size_t	equations		= 1000;
+
+    /* Number of array blocks and the number of members of each */
+    std::size_t	arrays			= 10;
+    unsigned	arraySize		= 8;
+
+    /* Number of computed tables and their number of points */
+    std::size_t	tables			= 5;
+    unsigned	tablePoints		= 101;
+
+    /* Number of markov processes and their number of states */
+    std::size_t	markovs			= 5;
+    unsigned	markovStates	= 2;
+
+    /* Number of function chains, where every function of a chain calls the
+     * previous one, and the length of the chains
+     */
+    std::size_t	functions		= 10;
+    unsigned	functionDepth	= 3;
+
+    /* Number of constants, which the equations refer to */
+    std::size_t	constants		= 10;
+
+    static xppModelSpec forLines(std::size_t lines);
+};
+
+/* Writes synthetic ode files, which contain every kind of statement the
+ * parser handles, so that its scaling can be measured on models of any size.
+ */
+class xppModelGenerator {
+public:
+    static std::size_t write	(const xppModelSpec &spec, std::ostream &stream);
+    static std::size_t write	(const xppModelSpec &spec, const std::string &fn);
+};
+
+#endif // XPPMODELGENERATOR_H
@@ -1,23 +1,140 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include "parser/xppEvaluator.h"
 #include "parser/xppParser.h"
 #include "settings/xppSettings.h"
 
+/**
+ * @brief collectOdeFiles Collects the ode files given on the command line
+ * @param arg Either an ode file, a directory that is searched recursively for
+ * ode files or a text file with one file name per line prefixed with '@'.
+ * @param paths The vector the file names are appended to.
+ */
+static void collectOdeFiles(const std::string &arg, std::vector<std::string> &paths) {
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream listStream(arg.substr(1).c_str(), std::ios::in);
+        std::string line;
+        while (getline(listStream, line)) {
+            if (!line.empty()) {
+                paths.push_back(line);
+            }
+        }
+        return;
+    }
+
+    struct stat info;
+    if (stat(arg.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        paths.push_back(arg);
+        return;
+    }
+
+    DIR *dir = opendir(arg.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    std::vector<std::string> entries;
+    while (dirent *entry = readdir(dir)) {
+        const std::string name(entry->d_name);
+        if (name != "." && name != "..") {
+            entries.push_back(arg + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    for (const std::string &entry : entries) {
+        if (stat(entry.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            collectOdeFiles(entry, paths);
+        } else if (entry.size() > 4 &&
+                   entry.compare(entry.size()-4, 4, ".ode") == 0) {
+            paths.push_back(entry);
+        }
+    }
+}
+
+/**
+ * @brief runStream Parses an ode file from the standard input with bounded
+ * memory and reports the number of definitions
+ */
+static int runStream(const xppParserConfig &config) {
+    std::size_t count = 0;
+    const bool success = xppParser::parseStream(
+                std::cin, [&count](optsType, const opts &) {++count;}, config);
+    if (success) {
+        std::cout << "Parsed " << count << " definitions" << std::endl;
+    }
+    return success ? 0 : 1;
+}
+
+/**
+ * @brief runBatch Parses many ode files and reports errors and throughput
+ */
+static int runBatch(const std::vector<std::string> &paths, const xppParserConfig &config) {
+    const xppParser::batchSummary summary = xppParser::parseMany(paths, config);
+    for (const xppParser::batchResult &result : summary.results) {
+        if (!result.error.empty()) {
+            std::cerr << result.fileName << ": " << result.error;
+        }
+    }
+    std::cout << "Parsed " << summary.results.size() << " files ("
+              << summary.failed << " failed), "
+              << summary.bytes/1.0e6 << " MB in " << summary.seconds << " s: "
+              << summary.filesPerSecond() << " files/s, "
+              << summary.megabytesPerSecond() << " MB/s" << std::endl;
+    if (config.stats) {
+        summary.stats.print(std::cout);
+    }
+    return summary.failed == 0 ? 0 : 1;
+}
+
 int main(int argc, char** argv)
 {
-    std::string filename;
-    if (argc < 2) {
-        filename = "../Test.ode";
-    } else {
-        filename = std::string(argv[1]);
+    std::string filename = "../Test.ode";
+    std::vector<std::string> batch;
+    bool batchMode = false;
+    bool streamMode = false;
+    xppParserConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "-j" && i+1 < argc) {
+            config.threads = std::stoul(argv[++i]);
+        } else if (arg == "--cache" && i+1 < argc) {
+            config.cacheDirectory = argv[++i];
+        } else if (arg == "--stats") {
+            config.stats = true;
+        } else if (arg == "--stream") {
+            streamMode = true;
+        } else if (arg == "--batch") {
+            batchMode = true;
+        } else if (batchMode) {
+            collectOdeFiles(arg, batch);
+        } else {
+            filename = arg;
+        }
+    }
+
+    if (streamMode) {
+        return runStream(config);
+    }
+    if (batchMode) {
+        return runBatch(batch, config);
+    }
+
+    xppParser parseOde(filename, config);
+    if (config.stats) {
+        parseOde.getStats().print(std::cout);
     }
-    xppParser parseOde(filename);
 
     xppSettings settings(parseOde.getOptions());
 
-    xppEvaluator evaluateOde(parseOde);
+    xppEvaluator evaluateOde(std::move(parseOde));
 
     return 0;
 }
@@ -0,0 +1,590 @@
+#ifndef COMPACTTRIE_HPP
+#define COMPACTTRIE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "keywordTrie.hpp"
+
+namespace keywordTrie {
+
+/**
+ * @brief The compactTrie class is a keyword trie stored as a double array.
+ *
+ * The trie class allocates every node separately, which scatters large
+ * dictionaries across the heap. Here a state is an index into contiguous
+ * arrays. The child of state s for character code c is the slot base[s]+c,
+ * which belongs to s if check[base[s]+c] == s. Failure and output links are
+ * 32 bit indices as well, so a state takes 20 bytes instead of a node with
+ * its own child vector.
+ *
+ * Keywords are collected first and the arrays are built from the sorted list
+ * in one pass, either by build() or before the next search, so a run of
+ * insertions builds them only once. The interface and the results are those
+ * of the trie class.
+ */
+class compactTrie {
+    /** Marks slots that belong to no state */
+    static const uint32_t none = 0xffffffffu;
+
+    struct unit {
+        uint32_t base  = 0;		/**< Offset of the children */
+        uint32_t check = none;	/**< Parent state of the slot */
+    };
+    struct link {
+        uint32_t failure = 0;	/**< Failure link */
+        uint32_t output	 = 0;	/**< Next state that reports a match */
+    };
+
+private:
+    resultCollection	keywords;	/**< Container of the result stubs */
+    bool caseSensitive = true;		/**< Flag for case sensitivity */
+    bool wholeWords	   = false;		/**< Flag for result validity */
+
+    /* The arrays are derived from the keywords. Keywords only mark them as
+     * outdated, they are rebuilt once before the next search
+     */
+    mutable std::vector<unit>	units;		/**< Transitions of every slot */
+    mutable std::vector<link>	links;		/**< Links of every slot */
+    mutable std::vector<int>	ids;		/**< Keyword index of every slot */
+    mutable uint16_t alphabet[256] = {};	/**< Character code of every byte */
+    mutable unsigned codes = 1;				/**< Number of codes including 0 */
+    mutable byteFilter firstBytes;			/**< Bytes that start a keyword */
+    mutable std::atomic<bool> arraysOutdated{false};	/**< Flag for outdated arrays */
+    mutable std::mutex		  arraysMutex;				/**< Guards the rebuild */
+
+public:
+    /**
+     * @brief compactTrie Initializes an empty trie, which only has a root.
+     */
+    compactTrie()
+        : units(1), links(1), ids(1, -1) {}
+    /**
+     * @brief compactTrie Copy an existing compact trie.
+     */
+    compactTrie(const compactTrie &Trie)
+        : compactTrie() {
+        caseSensitive = Trie.caseSensitive;
+        wholeWords	  = Trie.wholeWords;
+        keywords	  = Trie.keywords;
+        build();
+    }
+    /**
+     * @brief compactTrie Take over the arrays of an existing compact trie.
+     * The other trie is left empty.
+     */
+    compactTrie(compactTrie &&Trie)
+        : compactTrie() {
+        swap(Trie);
+    }
+
+    /**
+     * @brief operator= Exchange the arrays with another compact trie.
+     */
+    compactTrie &operator= (compactTrie &&Trie) {
+        swap(Trie);
+        return *this;
+    }
+
+    /**
+     * @brief swap Exchange the content of two compact tries.
+     */
+    void swap (compactTrie &Trie) {
+        keywords.swap(Trie.keywords);
+        std::swap(caseSensitive, Trie.caseSensitive);
+        std::swap(wholeWords, Trie.wholeWords);
+        units.swap(Trie.units);
+        links.swap(Trie.links);
+        ids.swap(Trie.ids);
+        std::swap(alphabet, Trie.alphabet);
+        std::swap(codes, Trie.codes);
+        std::swap(firstBytes, Trie.firstBytes);
+        const bool outdated = arraysOutdated.exchange(Trie.arraysOutdated);
+        Trie.arraysOutdated = outdated;
+    }
+
+    /**
+     * @brief addString Insert a new keyword into the trie.
+     * @param key The new keyword to be inserted.
+     * @param update Flag to signal whether the arrays should immediately be
+     * rebuilt. Otherwise they are rebuilt before the next search, so a run of
+     * insertions builds them only once.
+     */
+    void addString (const std::string &key, bool update) {
+        if (key.empty()) {
+            return;
+        }
+        keywords.push_back(result(key, keywords.size()));
+        arraysOutdated = true;
+        if (update) {
+            build();
+        }
+    }
+    /**
+     * @brief addString Wrapper around addString(std::string, bool), which
+     * defers the arrays to the next search.
+     * @param key The new keyword to be inserted.
+     */
+    void addString (const std::string &key) {addString(key, false);}
+
+    /**
+     * @brief addStrings Wrapper around addString(std::string, bool) to add a
+     * set of strings.
+     * @param keyList The set containing the keys.
+     */
+    void addString(const std::set<std::string> &keyList) {
+        for (const std::string &key : keyList) {
+            addString(key, false);
+        }
+        build();
+    }
+
+    /**
+     * @brief addStrings Wrapper around addString(std::string, bool) to add a
+     * vector of strings.
+     * @param keyList The vector containing the keys.
+     */
+    void addString(const std::vector<std::string> &keyList) {
+        keywords.reserve(keywords.size() + keyList.size());
+        for (const std::string &key : keyList) {
+            addString(key, false);
+        }
+        build();
+    }
+
+    /**
+     * @brief build Rebuilds the arrays from all keywords.
+     *
+     * Identical keywords are reported after the later one has been removed,
+     * so that the trie stays usable.
+     */
+    void build () {
+        std::lock_guard<std::mutex> lock(arraysMutex);
+        if (removeDuplicates(sortedKeywords())) {
+            buildArrays(sortedKeywords());
+            throw std::runtime_error(
+                        "Attempted to add two identical strings to the keyword tree.");
+        }
+        buildArrays(sortedKeywords());
+    }
+
+    /**
+     * @brief clear Removes all keywords from the trie.
+     */
+    void clear () {
+        keywords.clear();
+        build();
+    }
+
+    /**
+     * @brief memoryUsage Returns the bytes held by the arrays and keywords,
+     * without the overhead of the allocator.
+     */
+    std::size_t memoryUsage () const {
+        updateArrays();
+        std::size_t bytes = sizeof(*this) + units.capacity()*sizeof(unit) +
+                            links.capacity()*sizeof(link) + ids.capacity()*sizeof(int) +
+                            keywords.capacity()*sizeof(result);
+        for (const result &res : keywords) {
+            bytes += res.keyword.capacity();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief getStrings Returns all keywords in the order of insertion.
+     * @return Returns a vector with the keywords.
+     */
+    std::vector<std::string> getStrings () const {
+        std::vector<std::string> keyList;
+        keyList.reserve(keywords.size());
+        for (const result &res : keywords) {
+            keyList.push_back(res.keyword);
+        }
+        return keyList;
+    }
+
+    /**
+     * @brief getString Returns a single keyword.
+     * @param id The index of the keyword in the order of insertion.
+     */
+    const std::string &getString (unsigned id) const {
+        return keywords.at(id).keyword;
+    }
+
+    /**
+     * @brief forEachMatch Parses a text with the trie without allocating.
+     * @param text The text to be parsed.
+     * @param visit Callable with the keyword index, the starting and the end
+     * position of a match. Matches are reported in the order of parseText.
+     */
+    template<typename Visitor>
+    void forEachMatch (const std::string &text, Visitor &&visit) const {
+        updateArrays();
+        uint32_t state = 0;
+        for (unsigned i=0; i < text.size(); i++) {
+            /* Skip the bytes that cannot start a keyword */
+            if (state == 0) {
+                i = static_cast<unsigned>(firstBytes.next(text.data(), i, text.size()));
+                if (i == text.size()) {
+                    break;
+                }
+            }
+            const uint32_t code = alphabet[static_cast<unsigned char>(text[i])];
+            /* Bytes of no keyword always lead back to the root */
+            state = code == 0 ? 0 : findChild(state, code);
+            if (ids[state] != -1) {
+                const unsigned size = static_cast<unsigned>(keywords[ids[state]].keyword.size());
+                if (!wholeWords || size == text.size()) {
+                    visit(static_cast<unsigned>(ids[state]), i-size+1, i);
+                }
+            }
+            /* Process the output links for possible additional matches */
+            if (!wholeWords) {
+                for (uint32_t out = links[state].output; out != 0; out = links[out].output) {
+                    const unsigned size = static_cast<unsigned>(keywords[ids[out]].keyword.size());
+                    visit(static_cast<unsigned>(ids[out]), i-size+1, i);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief parseText Parses a text with the trie.
+     * @param text The text to be parsed.
+     * @return Returns a vector with all matches.
+     */
+    resultCollection parseText (const std::string &text) const {
+        resultCollection results;
+        forEachMatch(text, [&](unsigned id, unsigned, unsigned end) {
+            results.push_back(result(keywords[id], end));
+        });
+        return results;
+    }
+
+    /**
+     * @brief parseText Parses a text with the trie into a reusable buffer.
+     * @param text The text to be parsed.
+     * @param matches The buffer that is overwritten with all matches. Its
+     * memory is kept, so repeated searches do not allocate.
+     */
+    void parseText (const std::string &text, matchCollection &matches) const {
+        matches.clear();
+        forEachMatch(text, [&](unsigned id, unsigned start, unsigned end) {
+            matches.push_back(match{id, start, end});
+        });
+    }
+
+    /**
+     * @brief setCaseSensitivity Set the case sensitivity flag.
+     * @param flag The new flag.
+     */
+    void setCaseSensitivity (bool flag) {
+        caseSensitive = flag;
+        if (!keywords.empty()) {
+            throw std::runtime_error("Switching case sensitivity with existing "
+                                     "trie might lead to invalid results");
+        }
+    }
+
+    /**
+     * @brief setWholeWords Defines whether partial matches a valid.
+     * @param flag The new flag.
+     */
+    void setWholeWords (bool flag) {
+        wholeWords = flag;
+    }
+
+private:
+    /**
+     * @brief updateArrays Rebuilds the arrays if keywords were added since
+     * the last build. Concurrent searches wait for a single rebuild.
+     * Identical keywords cannot be removed here, so they are reported by
+     * every search until the next build() or clear().
+     */
+    void updateArrays () const {
+        if (!arraysOutdated.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(arraysMutex);
+        if (arraysOutdated.load(std::memory_order_relaxed)) {
+            const std::vector<uint32_t> order = sortedKeywords();
+            for (std::size_t i = 1; i < order.size(); ++i) {
+                if (compare(keywords[order[i-1]].keyword, keywords[order[i]].keyword) == 0) {
+                    throw std::runtime_error(
+                                "Attempted to add two identical strings to the keyword tree.");
+                }
+            }
+            buildArrays(order);
+        }
+    }
+
+    /**
+     * @brief sortedKeywords Returns the keyword indices in the order of
+     * their codes.
+     */
+    std::vector<uint32_t> sortedKeywords () const {
+        std::vector<uint32_t> order(keywords.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+            return compare(keywords[a].keyword, keywords[b].keyword) < 0;
+        });
+        return order;
+    }
+
+    /**
+     * @brief buildArrays Builds the arrays from the sorted keywords.
+     * @param order The keyword indices in sorted order without duplicates.
+     */
+    void buildArrays (const std::vector<uint32_t> &order) const {
+        std::fill(alphabet, alphabet+256, 0);
+        for (const result &res : keywords) {
+            for (const char &character : res.keyword) {
+                alphabet[fold(character)] = 1;
+            }
+        }
+        /* Codes follow the byte order, so sorted keys have sorted codes */
+        codes = 1;
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            if (alphabet[byte] != 0) {
+                alphabet[byte] = static_cast<uint16_t>(codes++);
+            }
+        }
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            alphabet[byte] = alphabet[fold(static_cast<char>(byte))];
+        }
+
+        units.assign(1, unit());
+        links.assign(1, link());
+        ids.assign(1, -1);
+        addFailureLinks(placeStates(order));
+
+        firstBytes.clear();
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            if (alphabet[byte] != 0 && units[units[0].base + alphabet[byte]].check == 0) {
+                firstBytes.add(static_cast<unsigned char>(byte));
+            }
+        }
+        arraysOutdated.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief fold Returns the byte a character is stored as.
+     */
+    unsigned char fold (char character) const {
+        const unsigned char byte = static_cast<unsigned char>(character);
+        return caseSensitive || byte >= 128 ?
+               byte : static_cast<unsigned char>(std::tolower(byte));
+    }
+
+    /**
+     * @brief compare Compares two keywords in the order of their codes.
+     */
+    int compare (const std::string &a, const std::string &b) const {
+        if (caseSensitive) {
+            return a.compare(b);
+        }
+        const std::size_t size = std::min(a.size(), b.size());
+        for (std::size_t i = 0; i < size; ++i) {
+            const unsigned char x = fold(a[i]);
+            const unsigned char y = fold(b[i]);
+            if (x != y) {
+                return x < y ? -1 : 1;
+            }
+        }
+        return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+    }
+
+    /**
+     * @brief removeDuplicates Removes the later of two identical keywords.
+     * @param order The keyword indices in sorted order.
+     * @return Returns true if a keyword was removed.
+     */
+    bool removeDuplicates (const std::vector<uint32_t> &order) {
+        std::vector<uint32_t> duplicates;
+        for (std::size_t i = 1; i < order.size(); ++i) {
+            if (compare(keywords[order[i-1]].keyword, keywords[order[i]].keyword) == 0) {
+                duplicates.push_back(std::max(order[i-1], order[i]));
+            }
+        }
+        if (duplicates.empty()) {
+            return false;
+        }
+        std::sort(duplicates.rbegin(), duplicates.rend());
+        duplicates.erase(std::unique(duplicates.begin(), duplicates.end()),
+                         duplicates.end());
+        for (const uint32_t index : duplicates) {
+            keywords.erase(keywords.begin() + index);
+        }
+        for (std::size_t i = 0; i < keywords.size(); ++i) {
+            keywords[i].id = i;
+        }
+        return true;
+    }
+
+    /**
+     * @brief findChild Returns the successor of a state, possibly after
+     * following failure links, or the root.
+     * @param state The current state.
+     * @param code The code of the character that is searched.
+     */
+    uint32_t findChild (uint32_t state, uint32_t code) const {
+        while (true) {
+            const uint32_t next = units[state].base + code;
+            if (units[next].check == state) {
+                return next;
+            }
+            if (state == 0) {
+                return 0;
+            }
+            state = links[state].failure;
+        }
+    }
+
+    /**
+     * @brief placeStates Creates the states of all keywords breadth first.
+     * @param order The keyword indices in sorted order.
+     * @return Returns the states in the order they were created.
+     *
+     * Every state covers the range of sorted keywords that share its prefix.
+     * The children are the distinct codes at the next position of the range,
+     * and they are placed at the first base where all their slots are free.
+     */
+    std::vector<uint32_t> placeStates (const std::vector<uint32_t> &order) const {
+        struct range {
+            uint32_t state;
+            uint32_t first;
+            uint32_t last;
+            uint32_t depth;
+        };
+        std::queue<range> pending;
+        pending.push(range{0, 0, static_cast<uint32_t>(order.size()), 0});
+        std::vector<uint32_t> states;
+        std::vector<uint32_t> children;
+        std::vector<uint32_t> bounds;
+        std::size_t nextFree = 1;
+        std::size_t lastSlot = 0;
+        while (!pending.empty()) {
+            const range current = pending.front();
+            pending.pop();
+
+            /* A keyword that ends here sorts before its extensions */
+            uint32_t first = current.first;
+            if (first < current.last &&
+                keywords[order[first]].keyword.size() == current.depth) {
+                ids[current.state] = static_cast<int>(order[first++]);
+            }
+            children.clear();
+            bounds.clear();
+            for (uint32_t i = first; i < current.last; ++i) {
+                const uint32_t code = alphabet[static_cast<unsigned char>(
+                                               keywords[order[i]].keyword[current.depth])];
+                if (children.empty() || children.back() != code) {
+                    children.push_back(code);
+                    bounds.push_back(i);
+                }
+            }
+            if (children.empty()) {
+                continue;
+            }
+            bounds.push_back(current.last);
+
+            const uint32_t base = findBase(children, nextFree);
+            units[current.state].base = base;
+            for (std::size_t k = 0; k < children.size(); ++k) {
+                const uint32_t slot = base + children[k];
+                units[slot].check = current.state;
+                lastSlot = std::max<std::size_t>(lastSlot, slot);
+                states.push_back(slot);
+                pending.push(range{slot, bounds[k], bounds[k+1], current.depth+1});
+            }
+        }
+
+        /* Every base plus any code stays within the arrays */
+        resize(lastSlot + codes);
+        units.shrink_to_fit();
+        links.shrink_to_fit();
+        ids.shrink_to_fit();
+        return states;
+    }
+
+    /**
+     * @brief findBase Searches the first base where the slots of all children
+     * are free.
+     * @param children The codes of the children in increasing order.
+     * @param nextFree The first slot that may be free, which is skipped ahead
+     * once the slots before it are almost all taken.
+     */
+    uint32_t findBase (const std::vector<uint32_t> &children, std::size_t &nextFree) const {
+        const std::size_t start = std::max<std::size_t>(nextFree, children.front()+1);
+        std::size_t taken = 0;
+        bool firstFree = true;
+        std::size_t slot = start;
+        for (;; ++slot) {
+            if (slot - children.front() + codes > units.size()) {
+                resize(std::max(2*units.size(), slot + codes));
+            }
+            if (units[slot].check != none) {
+                ++taken;
+                continue;
+            }
+            if (firstFree) {
+                nextFree  = slot;
+                firstFree = false;
+            }
+            const std::size_t base = slot - children.front();
+            bool fits = true;
+            for (std::size_t k = 1; k < children.size() && fits; ++k) {
+                fits = units[base + children[k]].check == none;
+            }
+            if (fits) {
+                break;
+            }
+        }
+        if (20*taken >= 19*(slot - start + 1)) {
+            nextFree = slot + 1;
+        }
+        if (slot - children.front() >= none - codes) {
+            throw std::length_error("Too many keywords for a compact trie.");
+        }
+        return static_cast<uint32_t>(slot - children.front());
+    }
+
+    /**
+     * @brief resize Resizes all arrays, new slots are free.
+     */
+    void resize (std::size_t size) const {
+        units.resize(size);
+        links.resize(size);
+        ids.resize(size, -1);
+    }
+
+    /**
+     * @brief addFailureLinks Creates the failure and output links.
+     * @param states All states except the root in breadth first order, so
+     * the links of a parent are known before those of its children.
+     */
+    void addFailureLinks (const std::vector<uint32_t> &states) const {
+        for (const uint32_t state : states) {
+            const uint32_t parent = units[state].check;
+            const uint32_t code   = state - units[parent].base;
+            const uint32_t failure = parent == 0 ?
+                                     0 : findChild(links[parent].failure, code);
+            links[state].failure = failure;
+            links[state].output	 = ids[failure] != -1 ? failure : links[failure].output;
+        }
+    }
+};
+
+} // namespace keywordTrie
+#endif // COMPACTTRIE_HPP
@@ -25,13 +25,26 @@
 
 #ifndef KEYWORDTRIE_HPP
 #define KEYWORDTRIE_HPP
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KEYWORDTRIE_HAVE_AVX2
+#endif
+
 namespace keywordTrie {
 
 /**
@@ -69,8 +82,114 @@ struct result {
           end(endPos) {}
 };
 
+/**
+ * @brief The match struct contains the position of a match. Unlike result it
+ * holds no copy of the keyword, so collecting matches does not allocate
+ * strings.
+ */
+struct match {
+    unsigned    id;			/**< The index of the keyword in the keyword list*/
+    unsigned    start;		/**< The starting position of the match */
+    unsigned    end;		/**< The end position of the match */
+};
+
 typedef std::vector<keywordTrie::result> resultCollection;
 typedef std::vector<resultCollection>	 resultTable;
+typedef std::vector<keywordTrie::match>	 matchCollection;
+typedef std::vector<matchCollection>	 matchTable;
+
+/**
+ * @brief The byteFilter struct contains the set of bytes that start a keyword.
+ *
+ * A search in the root can skip every other byte, as it neither leaves the
+ * root nor reports a match. The set is a bitmap of 16 rows indexed by the low
+ * nibble of a byte, where the bits of a row are the high nibbles 0-7 and 8-15
+ * of the first and second half. With AVX2 the bytes are looked up 32 at a
+ * time with byte shuffles of the rows, otherwise one at a time.
+ */
+struct byteFilter {
+    uint8_t rows[32] = {};	/**< Rows of the high nibbles 0-7 and 8-15 */
+
+    /**
+     * @brief add Inserts a byte into the set.
+     */
+    void add (unsigned char byte) {
+        rows[(byte >> 7)*16 + (byte & 15)] |= static_cast<uint8_t>(1u << ((byte >> 4) & 7));
+    }
+
+    /**
+     * @brief contains Checks whether a byte is in the set.
+     */
+    bool contains (unsigned char byte) const {
+        return (rows[(byte >> 7)*16 + (byte & 15)] >> ((byte >> 4) & 7)) & 1;
+    }
+
+    /**
+     * @brief clear Removes all bytes from the set.
+     */
+    void clear () {
+        std::fill(rows, rows+32, 0);
+    }
+
+    /**
+     * @brief next Finds the next byte of the set in a text.
+     * @param text The text that is searched.
+     * @param pos The position from which the search starts.
+     * @param size The size of the text.
+     * @return The position of the next byte of the set or size if there is
+     * none.
+     */
+    std::size_t next (const char *text, std::size_t pos, std::size_t size) const {
+#ifdef KEYWORDTRIE_HAVE_AVX2
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2 && pos + 32 <= size) {
+            pos = nextAVX2(text, pos, size);
+        }
+#endif
+        while (pos < size && !contains(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+        return pos;
+    }
+
+private:
+#ifdef KEYWORDTRIE_HAVE_AVX2
+    /**
+     * @brief nextAVX2 Searches the complete blocks of 32 bytes.
+     * @return The position of the next byte of the set or the start of the
+     * incomplete last block.
+     */
+    __attribute__((target("avx2")))
+    std::size_t nextAVX2 (const char *text, std::size_t pos, std::size_t size) const {
+        const __m256i low	 = _mm256_broadcastsi128_si256(
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows)));
+        const __m256i high	 = _mm256_broadcastsi128_si256(
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + 16)));
+        const __m256i bits	 = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128,
+                                                1, 2, 4, 8, 16, 32, 64, -128);
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        for (; pos + 32 <= size; pos += 32) {
+            const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+            const __m256i lo = _mm256_and_si256(v, nibble);
+            const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+            /* The sign bit of hi << 4 selects the rows of the high nibbles 8-15 */
+            const __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lo),
+                                                   _mm256_shuffle_epi8(high, lo),
+                                                   _mm256_slli_epi16(hi, 4));
+            const __m256i bit = _mm256_shuffle_epi8(bits, hi);
+            const __m256i miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit),
+                                                   _mm256_setzero_si256());
+            const unsigned found = ~static_cast<unsigned>(_mm256_movemask_epi8(miss));
+            if (found != 0) {
+                return pos + static_cast<unsigned>(__builtin_ctz(found));
+            }
+        }
+        return pos;
+    }
+#endif
+};
 
 /**
  * @brief The trie class representing the keyword trie.
@@ -83,6 +202,24 @@ private:
     node *root		   = nullptr;   /**< The root node */
     bool caseSensitive = true;      /**< Flag for case sensitivity */
     bool wholeWords    = false;     /**< Flag for result validity */
+    byteFilter firstBytes;			/**< Bytes that start a keyword */
+
+    /* Keywords only mark the failure links as outdated, they are rebuilt once
+     * before the next search
+     */
+    mutable std::atomic<bool> linksOutdated{false};	/**< Flag for outdated links */
+    mutable std::mutex		  linksMutex;			/**< Guards the rebuild */
+
+    /* Dense transition table of the compiled automaton, see compile() */
+    std::vector<uint32_t> transitions;	/**< Next state per state and class */
+    std::vector<int>	  stateIds;		/**< Keyword index of every state */
+    std::vector<unsigned> stateDepths;	/**< Depth of every state */
+    std::vector<uint32_t> stateOutputs;	/**< Output link of every state */
+    uint16_t alphabet[256] = {};		/**< Character class of every byte */
+    unsigned classes   = 0;				/**< Number of classes, 0 if not compiled */
+
+    /** Flag of transitions into states that report a match */
+    static const uint32_t matchFlag = 0x80000000u;
 
 public:
     /**
@@ -97,22 +234,66 @@ public:
      */
     trie(const trie &Trie)
         : trie() {
+        caseSensitive = Trie.caseSensitive;
+        wholeWords    = Trie.wholeWords;
         for (const result &res : Trie.keywords) {
             addString(res.keyword, false);
         }
-        addFailureLinks();
+        updateFailureLinks();
+        if (Trie.isCompiled()) {
+            compile();
+        }
+    }
+    /**
+     * @brief trie Take over the nodes of an existing keyword trie. The nodes
+     * stay in place, so the links between them remain valid. The other trie
+     * is left empty.
+     */
+    trie(trie &&Trie)
+        : trie() {
+        swap(Trie);
+    }
+
+    /**
+     * @brief operator= Exchange the nodes with another keyword trie.
+     */
+    trie &operator= (trie &&Trie) {
+        swap(Trie);
+        return *this;
+    }
+
+    /**
+     * @brief swap Exchange the content of two keyword tries.
+     */
+    void swap (trie &Trie) {
+        trieNodes.swap(Trie.trieNodes);
+        keywords.swap(Trie.keywords);
+        std::swap(root, Trie.root);
+        std::swap(caseSensitive, Trie.caseSensitive);
+        std::swap(wholeWords, Trie.wholeWords);
+        std::swap(firstBytes, Trie.firstBytes);
+        const bool outdated = linksOutdated.exchange(Trie.linksOutdated);
+        Trie.linksOutdated = outdated;
+        transitions.swap(Trie.transitions);
+        stateIds.swap(Trie.stateIds);
+        stateDepths.swap(Trie.stateDepths);
+        stateOutputs.swap(Trie.stateOutputs);
+        std::swap(alphabet, Trie.alphabet);
+        std::swap(classes, Trie.classes);
     }
 
     /**
      * @brief addString Insert a new keyword into the keyword trie.
      * @param key The new keyword to be inserted.
      * @param addFailure Flag to signal whether the failure links should
-     * immediately be updated.
+     * immediately be updated. Otherwise they are updated before the next
+     * search, so a run of insertions rebuilds them only once.
      */
     void addString (const std::string &key, bool addFailure) {
         if (key.empty()) {
             return;
         }
+        discardTable();
         node *current = root;
         for (const char &character : key) {
             const char c = caseSensitive ? character : std::tolower(character);
@@ -124,16 +305,24 @@ public:
         }
         current->id = keywords.size();
         keywords.push_back(result(key, keywords.size()));
+        /* Text bytes are folded before the search, so both cases start it */
+        firstBytes.add(static_cast<unsigned char>(key[0]));
+        if (!caseSensitive) {
+            firstBytes.add(static_cast<unsigned char>(std::tolower(key[0])));
+            firstBytes.add(static_cast<unsigned char>(std::toupper(key[0])));
+        }
 
+        linksOutdated = true;
         if (addFailure) {
-            addFailureLinks();
+            updateFailureLinks();
         }
     }
     /**
-     * @brief addString Wrapper around addString(std::string, bool).
+     * @brief addString Wrapper around addString(std::string, bool), which
+     * defers the failure links to the next search.
      * @param key The new keyword to be inserted.
      */
-    void addString (const std::string &key) {addString(key, true);}
+    void addString (const std::string &key) {addString(key, false);}
 
     /**
      * @brief addStrings Wrapper around addString(std::string, bool) to add a
@@ -144,7 +333,7 @@ public:
         for (const std::string &key : keyList) {
             addString(key, false);
         }
-        addFailureLinks();
+        updateFailureLinks();
     }
 
     /**
@@ -156,40 +345,205 @@ public:
         for (const std::string &key : keyList) {
             addString(key, false);
         }
-        addFailureLinks();
+        updateFailureLinks();
     }
 
     /**
-     * @brief parseText Parses a text with the trie.
+     * @brief clear Removes all keywords from the trie.
+     */
+    void clear () {
+        trieNodes.resize(1);
+        root->children.clear();
+        keywords.clear();
+        firstBytes.clear();
+        linksOutdated = false;
+        discardTable();
+    }
+
+    /**
+     * @brief compile Converts the finished automaton into a dense transition
+     * table.
+     * @param maxEntries The maximal number of entries of the table.
+     * @return Returns false if the table would be too large, in which case
+     * the trie is searched as before.
+     *
+     * Every byte is mapped to a character class, where case folding is part
+     * of the mapping and all bytes that appear in no keyword share a single
+     * class. The table holds the successor of every state for every class
+     * including the failure transitions, so that a search needs one lookup
+     * per byte. Adding keywords discards the table.
+     */
+    bool compile (std::size_t maxEntries = 1 << 24) {
+        discardTable();
+        updateFailureLinks();
+
+        /* Character classes of the edge labels, class 0 is any other byte */
+        uint16_t edgeClass[256] = {};
+        char representative[257] = {};
+        unsigned count = 1;
+        for (const nodeptr &n : trieNodes) {
+            const unsigned char c = static_cast<unsigned char>(n->c);
+            if (n.get() != root && edgeClass[c] == 0) {
+                representative[count] = n->c;
+                edgeClass[c] = static_cast<uint16_t>(count++);
+            }
+        }
+        if (trieNodes.size() >= matchFlag || trieNodes.size()*count > maxEntries) {
+            return false;
+        }
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            const unsigned folded = caseSensitive || byte >= 128 ?
+                                    byte : static_cast<unsigned>(std::tolower(byte));
+            alphabet[byte] = edgeClass[folded];
+        }
+
+        /* Number the states in the order of the node container, so that the
+         * root is state 0
+         */
+        std::unordered_map<const node*, uint32_t> index;
+        index.reserve(trieNodes.size());
+        for (const nodeptr &n : trieNodes) {
+            index.emplace(n.get(), static_cast<uint32_t>(index.size()));
+        }
+        stateIds.resize(trieNodes.size());
+        stateDepths.resize(trieNodes.size());
+        stateOutputs.resize(trieNodes.size());
+        for (std::size_t s = 0; s < trieNodes.size(); ++s) {
+            stateIds[s]		= trieNodes[s]->id;
+            stateDepths[s]	= trieNodes[s]->depth;
+            stateOutputs[s] = index.at(trieNodes[s]->output);
+        }
+
+        /* Resolve every transition once, including its failure links */
+        transitions.resize(trieNodes.size()*count);
+        for (std::size_t s = 0; s < trieNodes.size(); ++s) {
+            transitions[s*count] = 0;
+            for (unsigned k = 1; k < count; ++k) {
+                const uint32_t next = index.at(findChild(trieNodes[s].get(),
+                                                         representative[k]));
+                const bool match = stateIds[next] != -1 || stateOutputs[next] != 0;
+                transitions[s*count + k] = next | (match ? matchFlag : 0);
+            }
+        }
+        classes = count;
+        return true;
+    }
+
+    /**
+     * @brief isCompiled Returns whether the trie has a transition table.
+     */
+    bool isCompiled () const {return classes != 0;}
+
+    /**
+     * @brief memoryUsage Returns the bytes held by the nodes, the keywords and
+     * the transition table, without the overhead of the allocator.
+     */
+    std::size_t memoryUsage () const {
+        std::size_t bytes = sizeof(*this) + trieNodes.capacity()*sizeof(nodeptr) +
+                            keywords.capacity()*sizeof(result) +
+                            transitions.capacity()*sizeof(uint32_t) +
+                            stateIds.capacity()*sizeof(int) +
+                            stateDepths.capacity()*sizeof(unsigned) +
+                            stateOutputs.capacity()*sizeof(uint32_t);
+        for (const nodeptr &n : trieNodes) {
+            bytes += sizeof(node) + n->children.capacity()*sizeof(node*);
+        }
+        for (const result &res : keywords) {
+            bytes += res.keyword.capacity();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief getStrings Returns all keywords in the order of insertion.
+     * @return Returns a vector with the keywords.
+     */
+    std::vector<std::string> getStrings () const {
+        std::vector<std::string> keyList;
+        keyList.reserve(keywords.size());
+        for (const result &res : keywords) {
+            keyList.push_back(res.keyword);
+        }
+        return keyList;
+    }
+
+    /**
+     * @brief getString Returns a single keyword.
+     * @param id The index of the keyword in the order of insertion.
+     */
+    const std::string &getString (unsigned id) const {
+        return keywords.at(id).keyword;
+    }
+
+    /**
+     * @brief forEachMatch Parses a text with the trie without allocating.
      * @param text The text to be parsed.
-     * @return Returns a vector with all matches.
+     * @param visit Callable with the keyword index, the starting and the end
+     * position of a match. Matches are reported in the order of parseText.
      */
-    resultCollection parseText (const std::string &text) const {
-        resultCollection results;
+    template<typename Visitor>
+    void forEachMatch (const std::string &text, Visitor &&visit) const {
         if (text.empty()) {
-            return results;
+            return;
+        }
+        if (isCompiled()) {
+            forEachCompiled(text, visit);
+            return;
         }
+        updateFailureLinks();
         node *current= root;
         for (unsigned i=0; i < text.size(); i++) {
+            /* Skip the bytes that cannot start a keyword */
+            if (current == root) {
+                i = static_cast<unsigned>(firstBytes.next(text.data(), i, text.size()));
+                if (i == text.size()) {
+                    break;
+                }
+            }
             const char c = caseSensitive ? text.at(i) : std::tolower(text.at(i));
             current = findChild(current, c);
             if (current->id != -1) {
                 if (!wholeWords || current->depth == text.size()) {
-                    results.push_back(result(keywords.at(current->id), i));
+                    report(current->id, i, visit);
                 }
             }
             /* Process the output links for possible additional matches */
             if (!wholeWords) {
                 node *temp = current->output;
                 while (temp != root) {
-                    results.push_back(result(keywords.at(temp->id), i));
+                    report(temp->id, i, visit);
                     temp = temp->output;
                 }
             }
         }
+    }
+
+    /**
+     * @brief parseText Parses a text with the trie.
+     * @param text The text to be parsed.
+     * @return Returns a vector with all matches.
+     */
+    resultCollection parseText (const std::string &text) const {
+        resultCollection results;
+        forEachMatch(text, [&](unsigned id, unsigned, unsigned end) {
+            results.push_back(result(keywords[id], end));
+        });
         return results;
     }
 
+    /**
+     * @brief parseText Parses a text with the trie into a reusable buffer.
+     * @param text The text to be parsed.
+     * @param matches The buffer that is overwritten with all matches. Its
+     * memory is kept, so repeated searches do not allocate.
+     */
+    void parseText (const std::string &text, matchCollection &matches) const {
+        matches.clear();
+        forEachMatch(text, [&](unsigned id, unsigned start, unsigned end) {
+            matches.push_back(match{id, start, end});
+        });
+    }
+
     /**
      * @brief setCaseSensitivity Set the case sensitivity flag.
      * @param flag The new flag.
@@ -211,6 +565,65 @@ public:
     }
 
 private:
+    /**
+     * @brief report Passes a match to a visitor.
+     * @param id The index of the keyword.
+     * @param end The end position of the match.
+     * @param visit The visitor of forEachMatch.
+     */
+    template<typename Visitor>
+    void report (int id, unsigned end, Visitor &visit) const {
+        const unsigned size = static_cast<unsigned>(keywords[id].keyword.size());
+        visit(static_cast<unsigned>(id), end-size+1, end);
+    }
+
+    /**
+     * @brief forEachCompiled Parses a text with the transition table.
+     * @param text The text to be parsed.
+     * @param visit The visitor of forEachMatch.
+     */
+    template<typename Visitor>
+    void forEachCompiled (const std::string &text, Visitor &visit) const {
+        const uint32_t *table = transitions.data();
+        uint32_t state = 0;
+        for (unsigned i=0; i < text.size(); i++) {
+            if (state == 0) {
+                i = static_cast<unsigned>(firstBytes.next(text.data(), i, text.size()));
+                if (i == text.size()) {
+                    break;
+                }
+            }
+            const uint32_t next = table[state*classes +
+                                        alphabet[static_cast<unsigned char>(text[i])]];
+            state = next & ~matchFlag;
+            if ((next & matchFlag) == 0) {
+                continue;
+            }
+            if (stateIds[state] != -1) {
+                if (!wholeWords || stateDepths[state] == text.size()) {
+                    report(stateIds[state], i, visit);
+                }
+            }
+            /* Process the output links for possible additional matches */
+            if (!wholeWords) {
+                for (uint32_t out = stateOutputs[state]; out != 0; out = stateOutputs[out]) {
+                    report(stateIds[out], i, visit);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief discardTable Removes the transition table of a compiled trie.
+     */
+    void discardTable () {
+        transitions.clear();
+        stateIds.clear();
+        stateDepths.clear();
+        stateOutputs.clear();
+        classes = 0;
+    }
+
     /**
      * @brief addChild Add a child node to the trie.
      * @param parrent The pointer to the parrent node of the new one.
@@ -272,39 +685,48 @@ private:
         return root;
     }
 
+    /**
+     * @brief updateFailureLinks Rebuilds the failure links if keywords were
+     * added since the last update. Concurrent searches of a shared trie wait
+     * for a single rebuild.
+     */
+    void updateFailureLinks () const {
+        if (!linksOutdated.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(linksMutex);
+        if (linksOutdated.load(std::memory_order_relaxed)) {
+            addFailureLinks();
+            linksOutdated.store(false, std::memory_order_release);
+        }
+    }
+
     /**
      * @brief addFailureLinks Utilize a breadth first search to generate the
      * failure links.
+     *
+     * The links of all nodes are computed from scratch, which is linear in
+     * the total length of the keywords. A node fails to the child of the
+     * deepest node in the failure chain of its parent that continues with its
+     * character, so the links only depend on the set of keywords.
      */
-    void addFailureLinks() {
+    void addFailureLinks () const {
         std::queue<node*> q;
-        q.push(root);
+        for (node *child : root->children) {
+            child->failure = root;
+            child->output  = root;
+            q.push(child);
+        }
         while (!q.empty()) {
             node *temp = q.front();
+            q.pop();
             for (node *child : temp->children) {
+                child->failure = findChild(temp->failure, child->c);
+                /* Process the failure links for possible additional matches */
+                child->output  = child->failure->id != -1 ?
+                                 child->failure : child->failure->output;
                 q.push(child);
             }
-            /* A failure link with just one less charater is the optimum and will
-             * never change.
-             */
-            if (temp->failure->depth < temp->depth - 1) {
-                for (node *failchild : temp->parent->failure->children) {
-                    if (failchild->c == temp->c) {
-                        temp->failure = failchild;
-                    }
-                }
-            }
-
-            /* Process the failure links for possible additional matches */
-            node *out = temp->failure;
-            while (out != root) {
-                if (out->id != -1) {
-                    break;
-                }
-                out = out->failure;
-            }
-            temp->output = out;
-            q.pop();
         }
     }
 };
@@ -0,0 +1,393 @@
+#include "xppCompactModel.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+/* Number of entry spans: one per opts array and one for the Wieners */
+const std::size_t typeCount = std::tuple_size<optsCollection::arrayList>::value + 1;
+
+/**
+ * @brief writeArray Appends the size and the raw contents of an array
+ */
+template<typename T>
+void writeArray(std::string &buffer, const T *data, std::size_t size) {
+    const uint64_t count = size;
+    buffer.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    buffer.append(reinterpret_cast<const char*>(data), size*sizeof(T));
+}
+
+/**
+ * @brief readArray Reads an array that was written by writeArray
+ * @return False if the buffer is too short
+ */
+template<typename T, typename Container>
+bool readArray(const char *&data, const char *end, Container &target) {
+    uint64_t count;
+    if (std::size_t(end - data) < sizeof(count)) {
+        return false;
+    }
+    std::memcpy(&count, data, sizeof(count));
+    data += sizeof(count);
+    if (std::size_t(end - data) / sizeof(T) < count) {
+        return false;
+    }
+    target.resize(count);
+    if (count > 0) {
+        std::memcpy(&target[0], data, count*sizeof(T));
+    }
+    data += count*sizeof(T);
+    return true;
+}
+
+/**
+ * @brief inside Checks whether a span lies within an array of the given size
+ */
+inline bool inside(const xppCompactModel::span &s, std::size_t size) {
+    return s.offset <= size && s.size <= size - s.offset;
+}
+
+/**
+ * @brief narrow Converts an offset or size into a field of the model
+ * @throw std::length_error if the value does not fit into 32 bits
+ */
+inline uint32_t narrow(std::size_t value) {
+    if (value >= xppCompactModel::none) {
+        throw std::length_error("Model too large for a compact image\n");
+    }
+    return static_cast<uint32_t>(value);
+}
+
+/**
+ * @brief hasRange Checks whether a definition stems from an array statement or
+ * carries any other data that differs from a default optsRange
+ */
+inline bool hasRange(const optsRange &range) {
+    return range.Line != 0 || range.Start != 0 || range.End != 0 ||
+           range.Index != 0 || range.Symbolic || !range.Affine ||
+           !range.Indices.empty();
+}
+
+} // namespace
+
+/**
+ * @brief xppCompactModel::xppCompactModel Converts the opts arrays of a model
+ * @param collection The opts arrays.
+ * @throw std::length_error if the text or any array exceeds 32 bit offsets
+ */
+xppCompactModel::xppCompactModel(const optsCollection &collection) {
+    /* Size the flat arrays up front, so that they are allocated only once.
+     * Index lists are counted for every definition, even if they are shared.
+     */
+    std::size_t textSize = 0, extraCount = 0, argCount = 0, valueCount = 0;
+    std::size_t rangeCount = 0, indexCount = 0, entryCount = 1;
+    auto count = [&](const opts &opt) {
+        textSize += opt.Name.size() + opt.Expr.size();
+        for (const std::string &arg : opt.Args) {
+            textSize += arg.size();
+        }
+        for (const optsIndex &idx : opt.Range.Indices) {
+            textSize += idx.Array.size();
+        }
+        extraCount += !opt.Args.empty() || !opt.Values.empty();
+        argCount += opt.Args.size();
+        valueCount += opt.Values.size();
+        rangeCount += hasRange(opt.Range);
+        indexCount += opt.Range.Indices.size();
+    };
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        for (const opts &opt : collection.*array) {
+            count(opt);
+        }
+        entryCount += (collection.*array).size();
+    }
+    count(collection.Wieners);
+    arena.reserve(textSize);
+    extras.reserve(extraCount);
+    args.reserve(argCount);
+    values.reserve(valueCount);
+    ranges.reserve(rangeCount);
+    indices.reserve(indexCount);
+    entries.reserve(entryCount);
+    types.reserve(typeCount);
+
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        span type;
+        type.offset = narrow(entries.size());
+        type.size = narrow((collection.*array).size());
+        for (const opts &opt : collection.*array) {
+            entries.push_back(addOpts(opt));
+        }
+        types.push_back(type);
+    }
+    span wieners;
+    wieners.offset = narrow(entries.size());
+    wieners.size = 1;
+    entries.push_back(addOpts(collection.Wieners));
+    types.push_back(wieners);
+
+    /* Shared index lists leave room in the arena and the indices */
+    arena.shrink_to_fit();
+    indices.shrink_to_fit();
+}
+
+/**
+ * @brief xppCompactModel::toCollection Converts the model back into opts arrays
+ */
+optsCollection xppCompactModel::toCollection(void) const {
+    optsCollection collection;
+    if (types.empty()) {
+        return collection;
+    }
+    const optsCollection::arrayList &arrays = optsCollection::arrays();
+    for (std::size_t type = 0; type < arrays.size(); ++type) {
+        optsArray &target = collection.*arrays[type];
+        target.reserve(types[type].size);
+        for (std::size_t i = 0; i < types[type].size; ++i) {
+            target.push_back(toOpts(entries[types[type].offset + i]));
+        }
+    }
+    collection.Wieners = toOpts(entries[types[WIENERS].offset]);
+    return collection;
+}
+
+/**
+ * @brief xppCompactModel::toOpts Converts a single definition
+ */
+opts xppCompactModel::toOpts(const entry &e) const {
+    opts opt(e.line);
+    opt.Symbol = e.symbol;
+    opt.Name = text(e.name).str();
+    opt.Expr = text(e.expr).str();
+    if (e.extra != none) {
+        const extra &x = extras[e.extra];
+        opt.Args.reserve(x.args.size);
+        for (std::size_t i = 0; i < x.args.size; ++i) {
+            opt.Args.push_back(text(args[x.args.offset + i]).str());
+        }
+        opt.Values.assign(values.begin() + x.values.offset,
+                          values.begin() + x.values.offset + x.values.size);
+    }
+    if (e.range != none) {
+        const range &r = ranges[e.range];
+        opt.Range.Line	   = r.line;
+        opt.Range.Start	   = r.start;
+        opt.Range.End	   = r.end;
+        opt.Range.Index	   = r.index;
+        opt.Range.Symbolic = r.symbolic != 0;
+        opt.Range.Affine   = r.affine != 0;
+        opt.Range.Indices.reserve(r.indices.size);
+        for (std::size_t i = 0; i < r.indices.size; ++i) {
+            const index &idx = indices[r.indices.offset + i];
+            optsIndex target;
+            target.Array  = text(idx.array).str();
+            target.Stride = idx.stride;
+            target.Offset = idx.offset;
+            opt.Range.Indices.push_back(target);
+        }
+    }
+    return opt;
+}
+
+/**
+ * @brief xppCompactModel::size Returns the number of definitions of a type
+ */
+std::size_t xppCompactModel::size(optsType type) const {
+    return types.empty() ? 0 : types[type].size;
+}
+
+/**
+ * @brief xppCompactModel::at Returns the i-th definition of a type
+ */
+const xppCompactModel::entry &xppCompactModel::at(optsType type, std::size_t i) const {
+    return entries[types[type].offset + i];
+}
+
+/**
+ * @brief xppCompactModel::text Returns the text of a span of the arena
+ */
+xppStringRef xppCompactModel::text(const span &s) const {
+    xppStringRef ref;
+    ref.data = arena.data() + s.offset;
+    ref.size = s.size;
+    return ref;
+}
+
+/**
+ * @brief xppCompactModel::argCount Returns the number of arguments of a
+ * definition
+ */
+std::size_t xppCompactModel::argCount(const entry &e) const {
+    return e.extra == none ? 0 : extras[e.extra].args.size;
+}
+
+/**
+ * @brief xppCompactModel::arg Returns the i-th argument of a definition
+ */
+xppStringRef xppCompactModel::arg(const entry &e, std::size_t i) const {
+    return text(args[extras[e.extra].args.offset + i]);
+}
+
+/**
+ * @brief xppCompactModel::memoryUsage Returns the number of bytes allocated
+ * by the model
+ */
+std::size_t xppCompactModel::memoryUsage(void) const {
+    return arena.capacity() +
+           extras.capacity()*sizeof(extra) +
+           args.capacity()*sizeof(span) +
+           values.capacity()*sizeof(double) +
+           indices.capacity()*sizeof(index) +
+           ranges.capacity()*sizeof(range) +
+           entries.capacity()*sizeof(entry) +
+           types.capacity()*sizeof(span);
+}
+
+/**
+ * @brief xppCompactModel::serialize Appends the model to a buffer
+ *
+ * Every array is written as a whole. Numbers are stored in the native byte
+ * order, so the result is only meant to be read on the same machine.
+ */
+void xppCompactModel::serialize(std::string &buffer) const {
+    writeArray(buffer, arena.data(), arena.size());
+    writeArray(buffer, extras.data(), extras.size());
+    writeArray(buffer, args.data(), args.size());
+    writeArray(buffer, values.data(), values.size());
+    writeArray(buffer, indices.data(), indices.size());
+    writeArray(buffer, ranges.data(), ranges.size());
+    writeArray(buffer, entries.data(), entries.size());
+    writeArray(buffer, types.data(), types.size());
+}
+
+/**
+ * @brief xppCompactModel::deserialize Reads a model written by serialize
+ * @param data Pointer to the serialized model, which is advanced past it.
+ * @param end Pointer past the end of the buffer.
+ * @return False if the buffer is truncated or any span is out of bounds.
+ */
+bool xppCompactModel::deserialize(const char *&data, const char *end) {
+    if (!readArray<char>(data, end, arena) ||
+        !readArray<extra>(data, end, extras) ||
+        !readArray<span>(data, end, args) ||
+        !readArray<double>(data, end, values) ||
+        !readArray<index>(data, end, indices) ||
+        !readArray<range>(data, end, ranges) ||
+        !readArray<entry>(data, end, entries) ||
+        !readArray<span>(data, end, types) ||
+        types.size() != typeCount || types[WIENERS].size != 1) {
+        return false;
+    }
+
+    /* Verify all references, so that corrupted data is never accessed */
+    for (const span &type : types) {
+        if (!inside(type, entries.size())) {
+            return false;
+        }
+    }
+    for (const span &s : args) {
+        if (!inside(s, arena.size())) {
+            return false;
+        }
+    }
+    for (const extra &x : extras) {
+        if (!inside(x.args, args.size()) || !inside(x.values, values.size())) {
+            return false;
+        }
+    }
+    for (const index &idx : indices) {
+        if (!inside(idx.array, arena.size())) {
+            return false;
+        }
+    }
+    for (const range &r : ranges) {
+        if (!inside(r.indices, indices.size())) {
+            return false;
+        }
+    }
+    for (const entry &e : entries) {
+        if (!inside(e.name, arena.size()) || !inside(e.expr, arena.size()) ||
+            (e.extra != none && e.extra >= extras.size()) ||
+            (e.range != none && e.range >= ranges.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief xppCompactModel::addText Appends a string to the arena
+ */
+xppCompactModel::span xppCompactModel::addText(const std::string &str) {
+    span s;
+    s.offset = narrow(arena.size());
+    s.size = narrow(str.size());
+    arena.append(str);
+    return s;
+}
+
+/**
+ * @brief xppCompactModel::addOpts Appends the data of a definition
+ * @return The entry of the definition
+ */
+xppCompactModel::entry xppCompactModel::addOpts(const opts &opt) {
+    entry e;
+    e.line = opt.Line;
+    e.symbol = opt.Symbol;
+    e.name = addText(opt.Name);
+    e.expr = addText(opt.Expr);
+    e.extra = none;
+    if (!opt.Args.empty() || !opt.Values.empty()) {
+        extra x;
+        x.args.offset = narrow(args.size());
+        x.args.size = narrow(opt.Args.size());
+        for (const std::string &str : opt.Args) {
+            args.push_back(addText(str));
+        }
+        x.values.offset = narrow(values.size());
+        x.values.size = narrow(opt.Values.size());
+        values.insert(values.end(), opt.Values.begin(), opt.Values.end());
+        e.extra = narrow(extras.size());
+        extras.push_back(x);
+    }
+
+    const optsRange &source = opt.Range;
+    if (!hasRange(source)) {
+        e.range = none;
+        return e;
+    }
+    range r;
+    r.line = source.Line;
+    r.start = source.Start;
+    r.end = source.End;
+    r.index = source.Index;
+    r.symbolic = source.Symbolic;
+    r.affine = source.Affine;
+
+    /* Members of an array statement share the index list of the previous one */
+    bool shared = !ranges.empty() &&
+                  ranges.back().indices.size == source.Indices.size();
+    for (std::size_t i = 0; shared && i < source.Indices.size(); ++i) {
+        const index &idx = indices[ranges.back().indices.offset + i];
+        shared = text(idx.array) == source.Indices[i].Array &&
+                 idx.stride == source.Indices[i].Stride &&
+                 idx.offset == source.Indices[i].Offset;
+    }
+    if (shared) {
+        r.indices = ranges.back().indices;
+    } else {
+        r.indices.offset = narrow(indices.size());
+        r.indices.size = narrow(source.Indices.size());
+        for (const optsIndex &ref : source.Indices) {
+            index idx;
+            idx.array = addText(ref.Array);
+            idx.stride = ref.Stride;
+            idx.offset = ref.Offset;
+            indices.push_back(idx);
+        }
+    }
+    e.range = narrow(ranges.size());
+    ranges.push_back(r);
+    return e;
+}
@@ -0,0 +1,116 @@
+#ifndef XPPCOMPACTMODEL_H
+#define XPPCOMPACTMODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xppParserDefines.h"
+
+/* Read only reference to text within the arena of a compact model */
+struct xppStringRef {
+    const char	*data	= nullptr;
+    std::size_t	size	= 0;
+
+    std::string str		(void) const {return std::string(data, size);}
+    bool operator==		(const std::string &other) const {
+        return other.size() == size && other.compare(0, size, data, size) == 0;
+    }
+};
+
+/* Compact representation of the opts arrays of a parsed model. All text lives
+ * in a single arena and all other data in a few flat arrays of plain structs,
+ * which refer to each other by index spans. Compared to optsCollection there
+ * is no per definition heap allocation, so copying and storing a model are
+ * bulk copies of the arrays.
+ */
+class xppCompactModel {
+public:
+    /* Range [offset, offset+size) within one of the flat arrays */
+    struct span {
+        uint32_t	offset	= 0;
+        uint32_t	size	= 0;
+    };
+
+    /* Array reference of an optsRange, see optsIndex */
+    struct index {
+        span		array;
+        int32_t		stride;
+        int32_t		offset;
+    };
+
+    /* Array statement of a definition, see optsRange */
+    struct range {
+        uint32_t	line;
+        int32_t		start;
+        int32_t		end;
+        int32_t		index;
+        uint16_t	symbolic;
+        uint16_t	affine;
+        span		indices;
+    };
+
+    /* Arguments and table values of a definition. Args is a span of args,
+     * which in turn holds spans of the text, and values a span of values.
+     */
+    struct extra {
+        span		args;
+        span		values;
+    };
+
+    /* A single definition, see opts. Name and Expr are spans of the text. Only
+     * few definitions have arguments, table values or stem from an array
+     * statement, so these refer to the extras and ranges by index.
+     */
+    struct entry {
+        uint32_t	line;
+        uint32_t	symbol;
+        span		name;
+        span		expr;
+        uint32_t	extra;
+        uint32_t	range;
+    };
+
+    /* Index of entries without extras or array statement */
+    static const uint32_t none = static_cast<uint32_t>(-1);
+
+    xppCompactModel() = default;
+    explicit xppCompactModel(const optsCollection &collection);
+
+    optsCollection	toCollection	(void) const;
+    opts			toOpts			(const entry &e) const;
+
+    std::size_t		size	(optsType type) const;
+    const entry	   &at		(optsType type, std::size_t i) const;
+    xppStringRef	text	(const span &s) const;
+    std::size_t		argCount(const entry &e) const;
+    xppStringRef	arg		(const entry &e, std::size_t i) const;
+
+    std::size_t		memoryUsage	(void) const;
+
+    void serialize		(std::string &buffer) const;
+    bool deserialize	(const char *&data, const char *end);
+
+private:
+    span	addText		(const std::string &str);
+    entry	addOpts		(const opts &opt);
+
+    /* Text of all names, expressions and arguments */
+    std::string				arena;
+
+    /* Flat arrays that are referenced by the entries */
+    std::vector<extra>		extras;
+    std::vector<span>		args;
+    std::vector<double>		values;
+    std::vector<index>		indices;
+    std::vector<range>		ranges;
+
+    /* Definitions of all types, ordered by optsType. The entries of a type
+     * are given by its span, WIENERS being a single entry.
+     */
+    std::vector<entry>		entries;
+    std::vector<span>		types;
+};
+
+#endif // XPPCOMPACTMODEL_H
@@ -1,8 +1,23 @@
 #include "xppEvaluator.h"
 
+/**
+ * @brief xppEvaluator::xppEvaluator Evaluates a copy of a parsed ode file
+ * @param p The parser object, which is left unchanged
+ */
 xppEvaluator::xppEvaluator(xppParser &p)
-    :parser(xppParser(p))
+    :xppEvaluator(xppParser(p))
+{}
+
+/**
+ * @brief xppEvaluator::xppEvaluator Evaluates a parsed ode file in place
+ * @param p The parser object, which is taken over without copying its arrays
+ */
+xppEvaluator::xppEvaluator(xppParser &&p)
+    :parser(std::move(p))
 {
+    /* The evaluation works on the individual definitions */
+    parser.expandSymbolicArrays();
+
     /* The arrays containing the expressions that are replaced are at the
      * beginning of the array.
      */
@@ -37,9 +52,51 @@ keywordTrie::trie xppEvaluator::createTrie(const optsArray *array) {
         trie.addString(opt.Name);
     }
 
+    /* The trie searches every expression of the ode file */
+    trie.compile();
     return trie;
 }
 
+/**
+ * @brief Create a compact keyword trie from an opts array.
+ *
+ * @par expr: The opts array containing the expressions.
+ */
+keywordTrie::compactTrie xppEvaluator::createCompactTrie(const optsArray *array) {
+    keywordTrie::compactTrie trie;
+    for (const opts &opt : *array) {
+        trie.addString(opt.Name);
+    }
+    trie.build();
+    return trie;
+}
+
+/**
+ * @brief Checks whether the names of an opts array are searched with a
+ * compactTrie.
+ *
+ * trie::compile() builds its dense table only up to 2^24 entries, beyond
+ * which every search walks nodes that are scattered across the heap. If the
+ * names may exceed that limit, they are stored in the contiguous arrays of a
+ * compactTrie instead. The number of states is estimated by the total length
+ * of the names.
+ */
+bool xppEvaluator::needsCompactTrie(const optsArray *array) {
+    std::size_t states = 1;
+    std::size_t classes = 1;
+    bool used[256] = {};
+    for (const opts &opt : *array) {
+        states += opt.Name.size();
+        for (const char c : opt.Name) {
+            if (!used[static_cast<unsigned char>(c)]) {
+                used[static_cast<unsigned char>(c)] = true;
+                ++classes;
+            }
+        }
+    }
+    return states*classes > (std::size_t(1) << 24);
+}
+
 /**
  * @brief Create a emit_collection for all custom functions of the ode file.
  *
@@ -47,17 +104,19 @@ keywordTrie::trie xppEvaluator::createTrie(const optsArray *array) {
  * the function expression, as the arguments may change every time the function
  * is invoked.
  */
-keywordTrie::resultTable xppEvaluator::createResultTable(const optsArray *array) {
-    keywordTrie::resultTable table;
+keywordTrie::matchTable xppEvaluator::createResultTable(const optsArray *array) {
+    keywordTrie::matchTable table;
+    table.reserve(array->size());
     for (const opts &opt : *array) {
         keywordTrie::trie trie;
         trie.addString(opt.Args);
-        keywordTrie::resultCollection results = trie.parseText(opt.Expr);
+        keywordTrie::matchCollection results;
+        trie.parseText(opt.Expr, results);
         /* Reverse the order of the matches so the indices do not change
          * when expression is replaced
          */
         std::reverse(results.begin(), results.end());
-        table.push_back(results);
+        table.push_back(std::move(results));
     }
     return table;
 }
@@ -77,14 +136,14 @@ stringList xppEvaluator::getFunctionArgs (const std::string &str,
     size_t pos1 = start;
     size_t pos2 = str.find_first_of(",)", pos1);
     stringList args = {str.substr(pos1, pos2-pos1)};
-    if (parser.usedNames.parseText(args.back()).empty()) {
+    if (!parser.usedNames.contains(args.back())) {
         throw xppParserException(UNKNOWN_NAME, std::make_pair(str, ln), pos1);
     }
     while (pos2 < end) {
         pos1 = pos2+1;
         pos2 = str.find_first_of(",)", pos1);
         args.push_back(str.substr(pos1, pos2-pos1));
-        if (parser.usedNames.parseText(args.back()).empty()) {
+        if (!parser.usedNames.contains(args.back())) {
             throw xppParserException(UNKNOWN_NAME, std::make_pair(str, ln), pos1);
         }
     }
@@ -120,20 +179,36 @@ void xppEvaluator::replaceConstants(std::vector<optsArray*> &arrays) {
     for (size_t i=0; i < 3; ++i) {
         optsArray *source = arrays.at(0);
         arrays.erase(arrays.begin());
-        keywordTrie::trie trie = createTrie(source);
-        for (optsArray *target : arrays) {
-            for (opts &opt : *target) {
-                replaceExpression(trie, source, opt.Expr);
-            }
+        if (needsCompactTrie(source)) {
+            replaceConstants(createCompactTrie(source), source, arrays);
+        } else {
+            replaceConstants(createTrie(source), source, arrays);
         }
+    }
+}
 
-        /* Handle markov processes separately as the transition probabilities
-         * are stored in the args vector rather than the expression.
-         */
-        for (opts &opt : parser.Markovs) {
-            for (std::string &arg : opt.Args) {
-                replaceExpression(trie, source, arg);
-            }
+/**
+ * @brief Replace the constants of a single source array.
+ *
+ * @par trie: The trie with the names of the source array.
+ * @par source: The array containing the replacements.
+ * @par targets: The arrays that are searched.
+ */
+template<typename Trie>
+void xppEvaluator::replaceConstants(const Trie &trie, const optsArray *source,
+                                    const std::vector<optsArray*> &targets) {
+    for (optsArray *target : targets) {
+        for (opts &opt : *target) {
+            replaceExpression(trie, source, opt.Expr);
+        }
+    }
+
+    /* Handle markov processes separately as the transition probabilities
+     * are stored in the args vector rather than the expression.
+     */
+    for (opts &opt : parser.Markovs) {
+        for (std::string &arg : opt.Args) {
+            replaceExpression(trie, source, arg);
         }
     }
 }
@@ -145,16 +220,16 @@ void xppEvaluator::replaceConstants(std::vector<optsArray*> &arrays) {
  * @par source: The array containing the replacements.
  * @par str: The string that should be searched.
  */
-void xppEvaluator::replaceExpression(const keywordTrie::trie &trie,
+template<typename Trie>
+void xppEvaluator::replaceExpression(const Trie &trie,
                                      const optsArray *source,
                                      std::string &expr) {
-    keywordTrie::resultCollection results = trie.parseText(expr);
-    /* Reverse the order of the matches so the indices do not change
+    trie.parseText(expr, matches);
+    /* Replace the matches from the back so the indices do not change
      * when the expression is replaced.
      */
-    std::reverse(results.begin(), results.end());
-    for (keywordTrie::result &res : results) {
-        expr.replace(res.start, res.keyword.size(), source->at(res.id).Expr);
+    for (auto res = matches.rbegin(); res != matches.rend(); ++res) {
+        expr.replace(res->start, res->end-res->start+1, source->at(res->id).Expr);
     }
 }
 
@@ -166,9 +241,25 @@ void xppEvaluator::replaceExpression(const keywordTrie::trie &trie,
 void xppEvaluator::replaceFunctions(std::vector<optsArray*> &arrays) {
     optsArray *source = arrays.at(0);
     arrays.erase(arrays.begin());
-    keywordTrie::trie trie = createTrie(source);
-    keywordTrie::resultTable resTable = createResultTable(source);
-    for (optsArray *target : arrays) {
+    if (needsCompactTrie(source)) {
+        replaceFunctions(createCompactTrie(source), source, arrays);
+    } else {
+        replaceFunctions(createTrie(source), source, arrays);
+    }
+}
+
+/**
+ * @brief Replace the function calls of the functions in a source array.
+ *
+ * @par trie: The trie with the names of the source array.
+ * @par source: The array containing the functions.
+ * @par targets: The arrays that are searched.
+ */
+template<typename Trie>
+void xppEvaluator::replaceFunctions(const Trie &trie, const optsArray *source,
+                                    const std::vector<optsArray*> &targets) {
+    keywordTrie::matchTable resTable = createResultTable(source);
+    for (optsArray *target : targets) {
         for (opts &opt : *target) {
             replaceFunExpression(trie, resTable, opt.Expr, opt.Line);
         }
@@ -192,22 +283,22 @@ void xppEvaluator::replaceFunctions(std::vector<optsArray*> &arrays) {
  * @par str: The string that should be searched.
  * @par ln: The line number for error throws.
  */
-void xppEvaluator::replaceFunExpression(const keywordTrie::trie &trie,
-                                        const keywordTrie::resultTable &funTable,
+template<typename Trie>
+void xppEvaluator::replaceFunExpression(const Trie &trie,
+                                        const keywordTrie::matchTable &funTable,
                                         std::string &expr,
                                         const size_t &ln) {
-    keywordTrie::resultCollection results = trie.parseText(expr);
-    /* Reverse the order of the matches so the indices do not change
+    trie.parseText(expr, matches);
+    /* Replace the matches from the back so the indices do not change
      * when the expression is replaced.
      */
-    std::reverse(results.begin(), results.end());
-    for (keywordTrie::result &res : results) {
-        size_t pos = res.end+2;
+    for (auto res = matches.rbegin(); res != matches.rend(); ++res) {
+        size_t pos = res->end+2;
         stringList args = getFunctionArgs(expr, ln, pos);
-        std::string temp = parser.Functions.at(res.id).Expr;
-        for (const keywordTrie::result &res2 : funTable.at(res.id)) {
-            temp.replace(res2.start, res2.keyword.size(), args.at(res2.id));
+        std::string temp = parser.Functions.at(res->id).Expr;
+        for (const keywordTrie::match &res2 : funTable.at(res->id)) {
+            temp.replace(res2.start, res2.end-res2.start+1, args.at(res2.id));
         }
-        expr.replace(res.start, res.keyword.size()+pos, temp);
+        expr.replace(res->start, res->end-res->start+1+pos, temp);
     }
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "compactTrie.hpp"
 #include "keywordTrie.hpp"
 
 #include "xppParser.h"
@@ -15,16 +16,32 @@ class xppEvaluator
 public:
 
     xppEvaluator(xppParser &p);
+    xppEvaluator(xppParser &&p);
 
 private:
     xppParser   parser;
 
+    /* Buffer of the trie searches, which is reused for every expression */
+    keywordTrie::matchCollection matches;
+
     void replaceConstants			(std::vector<optsArray*> &arrays);
     void replaceFunctions			(std::vector<optsArray*> &arrays);
 
+    /* The substitutions for a single source array, which are searched with
+     * either a trie or a compactTrie
+     */
+    template<typename Trie>
+    void replaceConstants			(const Trie &trie, const optsArray *source,
+                                     const std::vector<optsArray*> &targets);
+    template<typename Trie>
+    void replaceFunctions			(const Trie &trie, const optsArray *source,
+                                     const std::vector<optsArray*> &targets);
+
     /* Helper functions */
     keywordTrie::trie	createTrie		(const optsArray *array);
-    keywordTrie::resultTable createResultTable(const optsArray *array);
+    keywordTrie::compactTrie createCompactTrie(const optsArray *array);
+    static bool		needsCompactTrie	(const optsArray *array);
+    keywordTrie::matchTable createResultTable(const optsArray *array);
     bool			isNumeric			(const std::string &str);
     stringList		getFunctionArgs		(const std::string &str,
                                          const size_t &ln,
@@ -32,11 +49,13 @@ private:
     std::string		getNextOperand		(const std::string &expr,
                                          size_t &pos1,
                                          size_t &pos2);
-    void			replaceExpression	(const keywordTrie::trie &trie,
+    template<typename Trie>
+    void			replaceExpression	(const Trie &trie,
                                          const optsArray *source,
                                          std::string &expr);
-    void			replaceFunExpression(const keywordTrie::trie &trie,
-                                         const keywordTrie::resultTable &funTable,
+    template<typename Trie>
+    void			replaceFunExpression(const Trie &trie,
+                                         const keywordTrie::matchTable &funTable,
                                          std::string &expr,
                                          const size_t &ln);
 };
@@ -0,0 +1,29 @@
+#ifndef XPPHASH_H
+#define XPPHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* 64 bit FNV-1a hash, which is used to recognize unchanged parts of ode files.
+ * Hashes can be chained by passing the previous result as seed.
+ */
+static const uint64_t xppHashSeed = 14695981039346656037ULL;
+
+inline uint64_t xppHash(const char *data, std::size_t size,
+                        uint64_t seed = xppHashSeed) {
+    for (std::size_t i = 0; i < size; ++i) {
+        seed ^= static_cast<unsigned char>(data[i]);
+        seed *= 1099511628211ULL;
+    }
+    return seed;
+}
+
+inline uint64_t xppHash(const std::string &str, uint64_t seed = xppHashSeed) {
+    /* Include the terminating zero, so that concatenations of different
+     * strings do not collide.
+     */
+    return xppHash(str.c_str(), str.size()+1, seed);
+}
+
+#endif // XPPHASH_H
@@ -0,0 +1,334 @@
+#include "xppIndexExpression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief fitsInt Checks whether a coefficient can be represented as int
+ */
+inline bool fitsInt(long long value) {
+    return value >= std::numeric_limits<int>::min() &&
+           value <= std::numeric_limits<int>::max();
+}
+
+/**
+ * @brief toInteger Converts an integral floating point value
+ * @return False if the value is not integral or out of range
+ */
+inline bool toInteger(double value, long long &result) {
+    if (!(std::fabs(value) < 9.0e15) || std::floor(value) != value) {
+        return false;
+    }
+    result = static_cast<long long>(value);
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief xppIndexExpression::xppIndexExpression Compiles an index expression
+ *
+ * @param expr The expression within the brackets.
+ */
+xppIndexExpression::xppIndexExpression(const std::string &expr)
+    : text(expr)
+{
+    skipSpaces();
+    compiled = parseSum() && pos == text.size();
+    if (compiled) {
+        /* Determine the maximal stack depth for the evaluation */
+        std::size_t size = 0;
+        for (const instruction &instr : program) {
+            if (instr.op == PUSH_CONST || instr.op == PUSH_J) {
+                depth = std::max(depth, ++size);
+            } else if (instr.op != NEG) {
+                --size;
+            }
+        }
+        analyseAffine();
+    } else {
+        program.clear();
+    }
+}
+
+/**
+ * @brief xppIndexExpression::evaluate Evaluates the expression for one index
+ * @param j The value of the index.
+ * @param value The resulting integer.
+ * @return False if the expression is not compiled or the result not integral
+ */
+bool xppIndexExpression::evaluate(int j, long long &value) const {
+    std::vector<long long> values;
+    if (!evaluate(j, j, values)) {
+        return false;
+    }
+    value = values.front();
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::evaluate Evaluates the expression for a range
+ * @param start The first index.
+ * @param end The last index.
+ * @param values The results for j = start, ..., end.
+ * @return False if the expression is not compiled or any result not integral
+ */
+bool xppIndexExpression::evaluate(int start, int end,
+                                  std::vector<long long> &values) const {
+    if (!compiled) {
+        return false;
+    }
+    values.clear();
+    if (end < start) {
+        return true;
+    }
+    values.reserve(static_cast<std::size_t>(end) - start + 1);
+
+    /* Affine expressions do not need the stack program */
+    if (affine) {
+        for (long long j = start; j <= end; ++j) {
+            values.push_back(a*j + b);
+        }
+        return true;
+    }
+
+    std::vector<double> stack(depth);
+    for (long long j = start; j <= end; ++j) {
+        std::size_t top = 0;
+        for (const instruction &instr : program) {
+            switch (instr.op) {
+            case PUSH_CONST:
+                stack[top++] = instr.value;
+                break;
+            case PUSH_J:
+                stack[top++] = static_cast<double>(j);
+                break;
+            case ADD:
+                --top;
+                stack[top-1] += stack[top];
+                break;
+            case SUB:
+                --top;
+                stack[top-1] -= stack[top];
+                break;
+            case MUL:
+                --top;
+                stack[top-1] *= stack[top];
+                break;
+            case DIV:
+                --top;
+                stack[top-1] /= stack[top];
+                break;
+            case POW:
+                --top;
+                stack[top-1] = std::pow(stack[top-1], stack[top]);
+                break;
+            case NEG:
+                stack[top-1] = -stack[top-1];
+                break;
+            }
+        }
+        long long value;
+        if (!toInteger(stack[0], value)) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::parseSum Parses a sum or difference of products
+ */
+bool xppIndexExpression::parseSum(void) {
+    if (!parseProduct()) {
+        return false;
+    }
+    while (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        const opcode op = text[pos++] == '+' ? ADD : SUB;
+        skipSpaces();
+        if (!parseProduct()) {
+            return false;
+        }
+        program.push_back(instruction{op, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::parseProduct Parses a product or quotient
+ */
+bool xppIndexExpression::parseProduct(void) {
+    if (!parseUnary()) {
+        return false;
+    }
+    while (pos < text.size() && (text[pos] == '*' || text[pos] == '/')) {
+        const opcode op = text[pos++] == '*' ? MUL : DIV;
+        skipSpaces();
+        if (!parseUnary()) {
+            return false;
+        }
+        program.push_back(instruction{op, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::parseUnary Parses a signed power. As in
+ * muparserx the sign binds weaker than the power, so -j^2 is -(j^2).
+ *
+ * muparserx rejects a sign that follows another sign and a leading '+' unless
+ * it belongs to a number, and reads signed numbers differently, e.g. --2^2 as
+ * -((-2)^2). Such expressions are not compiled, so that muparserx decides.
+ */
+bool xppIndexExpression::parseUnary(void) {
+    if (pos < text.size() && text[pos] == '+') {
+        return false;
+    }
+    if (pos < text.size() && text[pos] == '-') {
+        ++pos;
+        skipSpaces();
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+            return false;
+        }
+        if (!parsePower()) {
+            return false;
+        }
+        program.push_back(instruction{NEG, 0.0});
+        return true;
+    }
+    return parsePower();
+}
+
+/**
+ * @brief xppIndexExpression::parsePower Parses a right associative power
+ */
+bool xppIndexExpression::parsePower(void) {
+    if (!parseAtom()) {
+        return false;
+    }
+    if (pos < text.size() && text[pos] == '^') {
+        ++pos;
+        skipSpaces();
+        if (!parseUnary()) {
+            return false;
+        }
+        program.push_back(instruction{POW, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::parseAtom Parses a number, j or an expression in
+ * parentheses
+ */
+bool xppIndexExpression::parseAtom(void) {
+    if (pos >= text.size()) {
+        return false;
+    }
+    const char c = text[pos];
+    if (c == 'j' && (pos+1 == text.size() ||
+                     !(std::isalnum(static_cast<unsigned char>(text[pos+1])) ||
+                       text[pos+1] == '_'))) {
+        ++pos;
+        program.push_back(instruction{PUSH_J, 0.0});
+    } else if (c == '(') {
+        ++pos;
+        skipSpaces();
+        if (!parseSum() || pos >= text.size() || text[pos] != ')') {
+            return false;
+        }
+        ++pos;
+    } else if ((std::isdigit(static_cast<unsigned char>(c)) || c == '.') &&
+               text.compare(pos, 2, "0x") != 0 && text.compare(pos, 2, "0X") != 0) {
+        const char *begin = text.c_str() + pos;
+        char *end;
+        const double value = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        pos += end - begin;
+        program.push_back(instruction{PUSH_CONST, value});
+    } else {
+        return false;
+    }
+    skipSpaces();
+    return true;
+}
+
+/**
+ * @brief xppIndexExpression::skipSpaces Advances past whitespaces
+ */
+void xppIndexExpression::skipSpaces(void) {
+    while (pos < text.size() && text[pos] == ' ') {
+        ++pos;
+    }
+}
+
+/**
+ * @brief xppIndexExpression::analyseAffine Runs the program on linear forms
+ * a*j+b to determine whether the expression is affine. Only sums, differences
+ * and products with integer constants are considered, everything else is
+ * left to the stack program.
+ */
+void xppIndexExpression::analyseAffine(void) {
+    struct linearForm {
+        long long	a;
+        long long	b;
+    };
+    std::vector<linearForm> stack;
+    for (const instruction &instr : program) {
+        linearForm rhs = {0, 0};
+        if (instr.op != PUSH_CONST && instr.op != PUSH_J && instr.op != NEG) {
+            rhs = stack.back();
+            stack.pop_back();
+        }
+        switch (instr.op) {
+        case PUSH_CONST: {
+            long long value;
+            if (!toInteger(instr.value, value) || !fitsInt(value)) {
+                return;
+            }
+            stack.push_back(linearForm{0, value});
+            break;
+        }
+        case PUSH_J:
+            stack.push_back(linearForm{1, 0});
+            break;
+        case ADD:
+            stack.back().a += rhs.a;
+            stack.back().b += rhs.b;
+            break;
+        case SUB:
+            stack.back().a -= rhs.a;
+            stack.back().b -= rhs.b;
+            break;
+        case MUL: {
+            const linearForm lhs = stack.back();
+            if (lhs.a != 0 && rhs.a != 0) {
+                return;
+            }
+            stack.back().a = lhs.a*rhs.b + lhs.b*rhs.a;
+            stack.back().b = lhs.b*rhs.b;
+            break;
+        }
+        case NEG:
+            stack.back().a = -stack.back().a;
+            stack.back().b = -stack.back().b;
+            break;
+        default:
+            return;
+        }
+        if (!fitsInt(stack.back().a) || !fitsInt(stack.back().b)) {
+            return;
+        }
+    }
+    affine = true;
+    a = static_cast<int>(stack.back().a);
+    b = static_cast<int>(stack.back().b);
+}
@@ -0,0 +1,78 @@
+#ifndef XPPINDEXEXPRESSION_H
+#define XPPINDEXEXPRESSION_H
+
+#include <string>
+#include <vector>
+
+/* Integer expression in the array index j, as found within the brackets of
+ * array statements, e.g. "j-1" or "2*(j+1)". The expression is compiled once
+ * into a small stack program, which is then evaluated for a whole index range
+ * in a tight loop instead of parsing the text for every j.
+ *
+ * The arithmetic follows muparserx: numbers are floating point values, the
+ * operators are +, -, *, / and the right associative ^, and a result is only a
+ * valid index if it is integral. Expressions that use anything else, e.g.
+ * functions or signs muparserx reads differently like --j or +j, are not
+ * compiled and have to be evaluated by muparserx instead.
+ *
+ * If the expression is affine, i.e. of the form stride*j+offset, its
+ * coefficients are available without evaluating it at all.
+ */
+class xppIndexExpression {
+public:
+    explicit xppIndexExpression(const std::string &expr);
+
+    bool	isCompiled	(void) const {return compiled;}
+    bool	isAffine	(void) const {return affine;}
+    int		stride		(void) const {return a;}
+    int		offset		(void) const {return b;}
+
+    bool	evaluate	(int j, long long &value) const;
+    bool	evaluate	(int start, int end, std::vector<long long> &values) const;
+
+private:
+    /* Instructions of the stack program */
+    enum opcode {
+        PUSH_CONST,
+        PUSH_J,
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        POW,
+        NEG
+    };
+
+    struct instruction {
+        opcode	op;
+        double	value;
+    };
+
+    bool parseSum		(void);
+    bool parseProduct	(void);
+    bool parseUnary		(void);
+    bool parsePower		(void);
+    bool parseAtom		(void);
+    void skipSpaces		(void);
+    void analyseAffine	(void);
+
+    /* The compiled expression and the current parsing position */
+    const std::string			text;
+    std::size_t					pos		 = 0;
+
+    /* The stack program in postfix order */
+    std::vector<instruction>	program;
+
+    /* Maximal depth of the stack during evaluation */
+    std::size_t					depth	 = 0;
+
+    /* Flags whether the expression could be compiled and is affine in j */
+    bool						compiled = false;
+    bool						affine	 = false;
+
+    /* Coefficients of the affine expression */
+    int							a		 = 0;
+    int							b		 = 0;
+};
+
+#endif // XPPINDEXEXPRESSION_H
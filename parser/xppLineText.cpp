@@ -0,0 +1,322 @@
+#include "xppLineText.h"
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief xppLineText::copy::copy Takes over the text of a rewritten line and
+ * indexes it
+ * @param str The text of the line.
+ */
+xppLineText::copy::copy(std::string str)
+    : text(std::move(str)),
+      index(text.data(), text.size())
+{}
+
+/**
+ * @brief xppLineText::xppLineText Creates a view into a buffer without an
+ * index. Such a line only supports the interface of std::string, which is
+ * enough for lines that are only used in error messages.
+ * @param data Pointer to the first character of the line.
+ * @param size Number of characters in the line.
+ */
+xppLineText::xppLineText(const char *data, std::size_t size)
+    : text(data),
+      length(size)
+{}
+
+/**
+ * @brief xppLineText::xppLineText Creates a view into an indexed buffer
+ * @param data Pointer to the first character of the line.
+ * @param size Number of characters in the line.
+ * @param index The structural index of the buffer.
+ * @param offset The position of the line within the buffer.
+ */
+xppLineText::xppLineText(const char *data, std::size_t size,
+                         const xppStructuralIndex &index, std::size_t offset)
+    : text(data),
+      length(size),
+      index(&index),
+      offset(offset)
+{}
+
+/**
+ * @brief xppLineText::xppLineText Creates a line that owns its text
+ * @param text The text of the line.
+ */
+xppLineText::xppLineText(std::string text) {
+    adopt(std::unique_ptr<copy>(new copy(std::move(text))));
+}
+
+/**
+ * @brief xppLineText::xppLineText Copies a line. Views stay views into the
+ * same buffer, while the copy of a rewritten line is copied as well.
+ * @param other The line that is copied.
+ */
+xppLineText::xppLineText(const xppLineText &other)
+    : text(other.text),
+      length(other.length),
+      index(other.index),
+      offset(other.offset)
+{
+    if (other.owned) {
+        adopt(std::unique_ptr<copy>(new copy(*other.owned)));
+    }
+}
+
+/**
+ * @brief xppLineText::xppLineText Moves a line, which leaves an empty line
+ * @param other The line that is moved.
+ */
+xppLineText::xppLineText(xppLineText &&other)
+    : text(other.text),
+      length(other.length),
+      index(other.index),
+      offset(other.offset),
+      owned(std::move(other.owned))
+{
+    other = xppLineText();
+}
+
+/**
+ * @brief xppLineText::operator= Copies a line, see the copy constructor
+ * @param other The line that is copied.
+ */
+xppLineText &xppLineText::operator=(const xppLineText &other) {
+    if (this != &other) {
+        *this = xppLineText(other);
+    }
+    return *this;
+}
+
+/**
+ * @brief xppLineText::operator= Moves a line, which leaves an empty line
+ * @param other The line that is moved.
+ */
+xppLineText &xppLineText::operator=(xppLineText &&other) {
+    if (this != &other) {
+        text   = other.text;
+        length = other.length;
+        index  = other.index;
+        offset = other.offset;
+        owned  = std::move(other.owned);
+        other.text	 = "";
+        other.length = 0;
+        other.index	 = nullptr;
+        other.offset = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief xppLineText::ownedText Returns the copy of a rewritten line
+ */
+const std::string *xppLineText::ownedText(void) const {
+    return owned ? &owned->text : nullptr;
+}
+
+/**
+ * @brief xppLineText::ownedIndex Returns the index of a rewritten line
+ */
+const xppStructuralIndex *xppLineText::ownedIndex(void) const {
+    return owned ? &owned->index : nullptr;
+}
+
+/**
+ * @brief xppLineText::at Returns the character at a position
+ * @param pos The position of the character.
+ * @throw std::out_of_range if pos is not within the line, exactly as
+ * std::string::at would.
+ */
+char xppLineText::at(std::size_t pos) const {
+    if (pos >= length) {
+        return str().at(pos);
+    }
+    return text[pos];
+}
+
+/**
+ * @brief xppLineText::compare Compares a part of the line to a string
+ * @param pos The position of the first compared character.
+ * @param count The maximal number of compared characters.
+ * @param str The zero terminated string the part is compared to.
+ * @return The result of std::string::compare for the same arguments
+ */
+int xppLineText::compare(std::size_t pos, std::size_t count,
+                         const char *str) const {
+    if (pos > length) {
+        return this->str().compare(pos, count, str);
+    }
+    const std::size_t partSize = std::min(count, length - pos);
+    const std::size_t strSize = std::strlen(str);
+    const int result = std::char_traits<char>::compare(text + pos, str,
+                                                       std::min(partSize, strSize));
+    if (result != 0) {
+        return result;
+    }
+    return partSize < strSize ? -1 : partSize > strSize ? 1 : 0;
+}
+
+/**
+ * @brief xppLineText::substr Copies a part of the line
+ * @param pos The position of the first character.
+ * @param count The maximal number of characters.
+ * @throw std::out_of_range if pos is beyond the end of the line, exactly as
+ * std::string::substr would.
+ */
+std::string xppLineText::substr(std::size_t pos, std::size_t count) const {
+    if (pos > length) {
+        return str().substr(pos, count);
+    }
+    return std::string(text + pos, std::min(count, length - pos));
+}
+
+/**
+ * @brief xppLineText::find Finds the next occurence of a character
+ * @param c The character.
+ * @param pos The position from which the search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::find(char c, std::size_t pos) const {
+    if (pos >= length) {
+        return npos;
+    }
+    const void *found = std::memchr(text + pos, c, length - pos);
+    return found ? static_cast<const char*>(found) - text : npos;
+}
+
+/**
+ * @brief xppLineText::find Finds the next occurence of a string
+ * @param str The zero terminated string.
+ * @param pos The position from which the search starts.
+ * @return The position of the string or npos if there is none
+ */
+std::size_t xppLineText::find(const char *str, std::size_t pos) const {
+    const std::size_t strSize = std::strlen(str);
+    if (strSize == 1) {
+        return find(str[0], pos);
+    }
+    if (pos > length || strSize > length - pos) {
+        return npos;
+    }
+    for (std::size_t i = pos; i + strSize <= length; ++i) {
+        if (std::memcmp(text + i, str, strSize) == 0) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief xppLineText::find_first_of Finds the next character of a set
+ * @param chars The zero terminated set of characters.
+ * @param pos The position from which the search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::find_first_of(const char *chars, std::size_t pos) const {
+    for (std::size_t i = pos; i < length; ++i) {
+        if (std::strchr(chars, text[i]) && text[i] != '\0') {
+            return i;
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief xppLineText::find_first_not_of Finds the next character that is not
+ * part of a set
+ * @param chars The zero terminated set of characters.
+ * @param pos The position from which the search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::find_first_not_of(const char *chars, std::size_t pos) const {
+    for (std::size_t i = pos; i < length; ++i) {
+        if (!std::strchr(chars, text[i]) || text[i] == '\0') {
+            return i;
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief xppLineText::find_last_not_of Finds the last character that is not
+ * part of a set
+ * @param chars The zero terminated set of characters.
+ * @param pos The position at which the backward search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::find_last_not_of(const char *chars, std::size_t pos) const {
+    if (empty()) {
+        return npos;
+    }
+    for (std::size_t i = std::min(pos, length - 1) + 1; i-- > 0;) {
+        if (!std::strchr(chars, text[i]) || text[i] == '\0') {
+            return i;
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief xppLineText::next Finds the next character of a class
+ * @param cls The character class.
+ * @param pos The position from which the search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::next(xppStructuralIndex::characterClass cls,
+                              std::size_t pos) const {
+    if (pos >= length) {
+        return npos;
+    }
+    const std::size_t found = index->next(cls, offset + pos, offset + length);
+    return found == offset + length ? npos : found - offset;
+}
+
+/**
+ * @brief xppLineText::nextNot Finds the next character not in a class
+ * @param cls The character class.
+ * @param pos The position from which the search starts.
+ * @return The position of the character or npos if there is none
+ */
+std::size_t xppLineText::nextNot(xppStructuralIndex::characterClass cls,
+                                 std::size_t pos) const {
+    if (pos >= length) {
+        return npos;
+    }
+    const std::size_t found = index->nextNot(cls, offset + pos, offset + length);
+    return found == offset + length ? npos : found - offset;
+}
+
+/**
+ * @brief xppLineText::test Checks whether a character belongs to a class
+ * @param cls The character class.
+ * @param pos The position of the character within the line.
+ */
+bool xppLineText::test(xppStructuralIndex::characterClass cls,
+                       std::size_t pos) const {
+    return index->test(cls, offset + pos);
+}
+
+/**
+ * @brief xppLineText::assign Replaces the text of the line by a rewritten one
+ *
+ * The rewritten text is owned and indexed by the line, so that the buffer the
+ * line pointed into is never modified.
+ *
+ * @param str The new text of the line.
+ */
+void xppLineText::assign(std::string str) {
+    adopt(std::unique_ptr<copy>(new copy(std::move(str))));
+}
+
+/**
+ * @brief xppLineText::adopt Takes over a copy of the text and its index
+ * @param other The copy of the text.
+ */
+void xppLineText::adopt(std::unique_ptr<copy> other) {
+    owned  = std::move(other);
+    text   = owned->text.data();
+    length = owned->text.size();
+    index  = &owned->index;
+    offset = 0;
+}
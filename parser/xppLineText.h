@@ -0,0 +1,85 @@
+#ifndef XPPLINETEXT_H
+#define XPPLINETEXT_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "xppStructuralIndex.h"
+
+/* Text of a line of an ode file. A line that is used as it appears in the file
+ * is only a view into the buffer of the file, which has to outlive the line
+ * together with the structural index of the buffer. Only lines that have to
+ * be rewritten own a copy of their text, which is indexed on its own. So the
+ * structural characters of every line are found through next, nextNot and
+ * test. The read only interface mirrors the part of std::string that the
+ * parser works with.
+ */
+class xppLineText {
+public:
+    static const std::size_t npos = std::string::npos;
+
+    xppLineText(void) = default;
+    xppLineText(const char *data, std::size_t size);
+    xppLineText(const char *data, std::size_t size,
+                const xppStructuralIndex &index, std::size_t offset);
+    xppLineText(std::string text);
+    xppLineText(const xppLineText &other);
+    xppLineText(xppLineText &&other);
+
+    xppLineText &operator=(const xppLineText &other);
+    xppLineText &operator=(xppLineText &&other);
+
+    const char *data	(void) const {return text;}
+    std::size_t	size	(void) const {return length;}
+    bool		empty	(void) const {return length == 0;}
+    const char *begin	(void) const {return text;}
+    const char *end		(void) const {return text + length;}
+    char operator[]		(std::size_t pos) const {return text[pos];}
+    std::string	str		(void) const {return std::string(text, length);}
+
+    /* The copy of a rewritten line and its index, or nullptr for a view */
+    const std::string		  *ownedText	(void) const;
+    const xppStructuralIndex  *ownedIndex	(void) const;
+
+    char		at		(std::size_t pos) const;
+    int			compare	(std::size_t pos, std::size_t count, const char *str) const;
+    std::string	substr	(std::size_t pos = 0, std::size_t count = npos) const;
+
+    std::size_t	find				(char c, std::size_t pos = 0) const;
+    std::size_t	find				(const char *str, std::size_t pos = 0) const;
+    std::size_t	find_first_of		(const char *chars, std::size_t pos = 0) const;
+    std::size_t	find_first_not_of	(const char *chars, std::size_t pos = 0) const;
+    std::size_t	find_last_not_of	(const char *chars, std::size_t pos = npos) const;
+
+    /* Searches of the structural index, which return npos if there is none */
+    std::size_t	next	(xppStructuralIndex::characterClass cls, std::size_t pos) const;
+    std::size_t	nextNot	(xppStructuralIndex::characterClass cls, std::size_t pos) const;
+    bool		test	(xppStructuralIndex::characterClass cls, std::size_t pos) const;
+
+    void		assign	(std::string str);
+
+private:
+    /* Copy of a rewritten line together with its index */
+    struct copy {
+        explicit copy(std::string str);
+
+        std::string			text;
+        xppStructuralIndex	index;
+    };
+
+    void adopt (std::unique_ptr<copy> other);
+
+    /* The text, which is either a view or points into owned */
+    const char	*text	= "";
+    std::size_t	length	= 0;
+
+    /* The index of the buffer of the text and the position of the text in it */
+    const xppStructuralIndex *index = nullptr;
+    std::size_t	offset	= 0;
+
+    /* Copy of the text of a rewritten line */
+    std::unique_ptr<copy> owned;
+};
+
+#endif // XPPLINETEXT_H
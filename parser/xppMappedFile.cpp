@@ -0,0 +1,72 @@
+#include "xppMappedFile.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define XPP_HAVE_MMAP
+#endif
+
+/**
+ * @brief xppMappedFile::xppMappedFile Maps the given file into memory
+ *
+ * @param fn The name of the file
+ *
+ * If the file cannot be mapped, e.g. because it is a pipe, its content is read
+ * into an owned buffer. Whether the file could be opened at all is reported
+ * by isOpen.
+ */
+xppMappedFile::xppMappedFile(const std::string &fn) {
+#ifdef XPP_HAVE_MMAP
+    int fd = ::open(fn.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        opened = true;
+        if (info.st_size == 0) {
+            ::close(fd);
+            return;
+        }
+        void *addr = ::mmap(nullptr, static_cast<std::size_t>(info.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, static_cast<std::size_t>(info.st_size),
+                      MADV_SEQUENTIAL);
+            begin  = static_cast<const char*>(addr);
+            length = static_cast<std::size_t>(info.st_size);
+            mapped = true;
+            ::close(fd);
+            return;
+        }
+    }
+    ::close(fd);
+#endif
+    /* Fallback to reading the whole content */
+    std::ifstream fileStream(fn.c_str(), std::ios::in | std::ios::binary);
+    if (fileStream.fail()) {
+        opened = false;
+        return;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(fileStream),
+                  std::istreambuf_iterator<char>());
+    begin  = buffer.data();
+    length = buffer.size();
+    opened = true;
+}
+
+/**
+ * @brief xppMappedFile::~xppMappedFile Releases the mapping
+ */
+xppMappedFile::~xppMappedFile() {
+#ifdef XPP_HAVE_MMAP
+    if (mapped) {
+        ::munmap(const_cast<char*>(begin), length);
+    }
+#endif
+}
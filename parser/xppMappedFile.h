@@ -0,0 +1,42 @@
+#ifndef XPPMAPPEDFILE_H
+#define XPPMAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/* Read only view of a complete file. On POSIX systems the file is memory
+ * mapped, so that the parser can work on the pages of the file directly
+ * instead of copying them into a std::string first. If mapping is not
+ * possible the content is read into an owned buffer instead.
+ */
+class xppMappedFile {
+public:
+    explicit xppMappedFile(const std::string &fn);
+    ~xppMappedFile();
+
+    xppMappedFile(const xppMappedFile &) = delete;
+    xppMappedFile &operator=(const xppMappedFile &) = delete;
+
+    bool		isOpen		(void) const {return opened;}
+    bool		isMapped	(void) const {return mapped;}
+    const char *data		(void) const {return begin;}
+    std::size_t	size		(void) const {return length;}
+
+private:
+    /* Pointer to the first byte of the file content */
+    const char	*begin	= "";
+
+    /* Number of bytes in the file */
+    std::size_t	length	= 0;
+
+    /* Flag whether the file could be opened */
+    bool		opened	= false;
+
+    /* Flag whether the content is memory mapped or owned by buffer */
+    bool		mapped	= false;
+
+    /* Fallback storage if the file cannot be mapped */
+    std::string	buffer;
+};
+
+#endif // XPPMAPPEDFILE_H
@@ -0,0 +1,245 @@
+#include "xppModelCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "xppCompactModel.h"
+#include "xppHash.h"
+#include "xppMappedFile.h"
+
+namespace {
+
+/* Identification of the image format. The version has to be increased
+ * whenever the layout of the image or the parsed representation changes.
+ */
+const char			imageMagic[8] = {'X', 'P', 'P', 'M', 'O', 'D', 'E', 'L'};
+const uint32_t		imageVersion  = 6;
+
+/**
+ * @brief The imageWriter class serializes a model into a byte buffer.
+ * Numbers are stored in the native byte order, as images are only meant to be
+ * read on the machine that wrote them.
+ */
+class imageWriter {
+public:
+    template<typename T>
+    void write(const T &value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void write(const std::string &str) {
+        write(static_cast<uint32_t>(str.size()));
+        buffer.append(str);
+    }
+    void write(const stringList &list) {
+        write(static_cast<uint32_t>(list.size()));
+        for (const std::string &str : list) {
+            write(str);
+        }
+    }
+    void write(const xppCompactModel &model) {
+        model.serialize(buffer);
+    }
+
+    std::string	buffer;
+};
+
+/**
+ * @brief The imageReader class deserializes a model from a byte buffer. Every
+ * read is checked against the end of the buffer, so that truncated or
+ * corrupted images are rejected instead of being misread.
+ */
+class imageReader {
+public:
+    imageReader(const char *data, std::size_t size)
+        : current(data), end(data + size) {}
+
+    template<typename T>
+    bool read(T &value) {
+        if (std::size_t(end - current) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, current, sizeof(T));
+        current += sizeof(T);
+        return true;
+    }
+    bool read(std::string &str) {
+        uint32_t length;
+        if (!read(length) || std::size_t(end - current) < length) {
+            return false;
+        }
+        str.assign(current, length);
+        current += length;
+        return true;
+    }
+    bool read(stringList &list) {
+        uint32_t count;
+        if (!read(count) || std::size_t(end - current) < count) {
+            return false;
+        }
+        list.resize(count);
+        for (std::string &str : list) {
+            if (!read(str)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool read(xppCompactModel &model) {
+        return model.deserialize(current, end);
+    }
+    bool atEnd(void) const {return current == end;}
+
+private:
+    const char *current;
+    const char *end;
+};
+
+/**
+ * @brief fileHash Hashes the contents of a file
+ * @param fn The name of the file
+ * @param hash The resulting hash
+ * @return False if the file cannot be read
+ */
+bool fileHash(const std::string &fn, uint64_t &hash) {
+    xppMappedFile file(fn);
+    if (!file.isOpen()) {
+        return false;
+    }
+    hash = xppModelCache::contentHash(file.data(), file.size());
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief xppModelCache::xppModelCache Constructor of the cache
+ * @param directory The directory that contains the images. It has to exist.
+ * @param symbolicArrays Whether the models keep symbolic array families.
+ */
+xppModelCache::xppModelCache(const std::string &directory, bool symbolicArrays)
+    : directory(directory),
+      symbolicArrays(symbolicArrays)
+{}
+
+/**
+ * @brief xppModelCache::contentHash Hashes the contents of an ode or table file
+ * @param data Pointer to the file content.
+ * @param size Number of bytes of the file content.
+ */
+uint64_t xppModelCache::contentHash(const char *data, std::size_t size) {
+    return xppHash(data, size);
+}
+
+/**
+ * @brief xppModelCache::load Loads the image of an ode file
+ * @param key The hash of the contents of the ode file.
+ * @param size The size of the ode file, which guards against hash collisions.
+ * @param result The model the image is read into.
+ * @return False if there is no valid image or a referenced table file changed.
+ * In that case result is left in an unspecified state.
+ */
+bool xppModelCache::load(uint64_t key, std::size_t size, model &result) const {
+    xppMappedFile image(imageName(key));
+    if (!image.isOpen()) {
+        return false;
+    }
+    imageReader reader(image.data(), image.size());
+
+    /* Check the header */
+    char magic[sizeof(imageMagic)];
+    uint32_t version;
+    uint64_t storedKey, storedSize;
+    uint8_t symbolic;
+    if (!reader.read(magic) || std::memcmp(magic, imageMagic, sizeof(magic)) != 0 ||
+        !reader.read(version) || version != imageVersion ||
+        !reader.read(storedKey) || storedKey != key ||
+        !reader.read(storedSize) || storedSize != size ||
+        !reader.read(symbolic) || symbolic != uint8_t(symbolicArrays)) {
+        return false;
+    }
+
+    /* Verify that the table and library files did not change */
+    if (!reader.read(result.tableFiles)) {
+        return false;
+    }
+    for (const std::string &fn : result.tableFiles) {
+        uint64_t storedHash, currentHash;
+        if (!reader.read(storedHash) || !fileHash(fn, currentHash) ||
+            storedHash != currentHash) {
+            return false;
+        }
+    }
+
+    /* Read the model */
+    xppCompactModel compact;
+    if (!reader.read(result.names) || !reader.read(compact) || !reader.atEnd()) {
+        return false;
+    }
+    result.opts = compact.toCollection();
+    return true;
+}
+
+/**
+ * @brief xppModelCache::store Writes the image of an ode file
+ * @param key The hash of the contents of the ode file.
+ * @param size The size of the ode file.
+ * @param source The parsed model.
+ * @return False if the image could not be written.
+ *
+ * The image is written to a unique temporary file that is renamed afterwards,
+ * so that concurrent readers never see a partially written image.
+ */
+bool xppModelCache::store(uint64_t key, std::size_t size,
+                          const model &source) const {
+    imageWriter writer;
+    writer.write(imageMagic);
+    writer.write(imageVersion);
+    writer.write(key);
+    writer.write(static_cast<uint64_t>(size));
+    writer.write(static_cast<uint8_t>(symbolicArrays));
+
+    writer.write(source.tableFiles);
+    for (const std::string &fn : source.tableFiles) {
+        uint64_t hash;
+        if (!fileHash(fn, hash)) {
+            return false;
+        }
+        writer.write(hash);
+    }
+
+    writer.write(source.names);
+    try {
+        writer.write(xppCompactModel(source.opts));
+    } catch (const std::length_error &) {
+        /* The model is too large for an image */
+        return false;
+    }
+
+    const std::string fn = imageName(key);
+    const std::string temp = fn + ".tmp" + std::to_string(
+                std::chrono::steady_clock::now().time_since_epoch().count());
+    std::ofstream imageStream(temp.c_str(), std::ios::out | std::ios::binary);
+    if (!imageStream.write(writer.buffer.data(), writer.buffer.size())) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    imageStream.close();
+    if (std::rename(temp.c_str(), fn.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief xppModelCache::imageName Returns the file name of the image of a key
+ */
+std::string xppModelCache::imageName(uint64_t key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx",
+                  static_cast<unsigned long long>(key));
+    return directory + "/" + name + ".xppmodel";
+}
@@ -0,0 +1,46 @@
+#ifndef XPPMODELCACHE_H
+#define XPPMODELCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "xppParserDefines.h"
+
+/* Directory of binary images of parsed ode files. An image contains all opts
+ * arrays including computed tables, the Wieners and the declared names, so
+ * that a later run can skip parsing entirely. Images are keyed by the hash of
+ * the ode file contents and record whether symbolic array families were kept. The table and library files an ode file refers to are
+ * stored in the image together with the hash of their contents and are
+ * verified on every load, so that editing such a file invalidates the image as
+ * well.
+ */
+class xppModelCache {
+public:
+    /* The parsed content of an ode file that is stored in an image */
+    struct model {
+        optsCollection	opts;
+        stringList		names;
+        stringList		tableFiles;
+    };
+
+    explicit xppModelCache(const std::string &directory, bool symbolicArrays = false);
+
+    static uint64_t contentHash(const char *data, std::size_t size);
+
+    bool load	(uint64_t key, std::size_t size, model &result) const;
+    bool store	(uint64_t key, std::size_t size, const model &source) const;
+
+private:
+    std::string imageName(uint64_t key) const;
+
+    /* Directory that contains the images */
+    const std::string directory;
+
+    /* Whether the models keep symbolic array families, see
+     * xppParserConfig::symbolicArrays. Images of the other kind are rejected.
+     */
+    const bool symbolicArrays;
+};
+
+#endif // XPPMODELCACHE_H
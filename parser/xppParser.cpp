@@ -4,157 +4,352 @@
  * @brief xppParser::xppParser Default constructor of the parser object
  *
  * @param fn string representing the file name of the ode file
+ * @param threads The number of threads used to process the file
+ *
+ * This constructs the parser object of a given ode file. Errors are printed to
+ * the standard error stream.
+ */
+xppParser::xppParser(const std::string &fn, unsigned threads)
+    : xppParser(fn, [threads]() {
+                    xppParserConfig config;
+                    config.threads = threads;
+                    return config;
+                }(), nullptr)
+{}
+
+/**
+ * @brief xppParser::xppParser Constructor of the parser object with settings
+ *
+ * @param fn string representing the file name of the ode file
+ * @param config The settings of the parser
+ *
+ * This constructs the parser object of a given ode file. Errors are printed to
+ * the standard error stream.
+ */
+xppParser::xppParser(const std::string &fn, const xppParserConfig &config)
+    : xppParser(fn, config, nullptr)
+{}
+
+/**
+ * @brief xppParser::xppParser Constructor of the parser object
+ *
+ * @param fn string representing the file name of the ode file
+ * @param config The settings of the parser
+ * @param error If not null, errors are stored there instead of being printed
  *
  * This constructs the parser object of a given ode file. First unneeded
  * content is discarded, and a basic correctness check is don. Later arrays are
  * expanded and special constructs like markov processes and tables are handled.
  * Finally, the different keywords are parsed and put into the opts arrays.
+ *
+ * The latter steps are done for chunks of the file in parallel. The results
+ * of the chunks are merged in the original order, so that the result does not
+ * depend on the number of threads. In incremental mode every statement forms
+ * its own chunk, whose position in the model is kept for later updates.
  */
-xppParser::xppParser(const std::string &fn)
-    : fileName(fn)
+xppParser::xppParser(const std::string &fn, const xppParserConfig &config,
+                     std::string *error)
+    : fileName(fn),
+      config(config),
+      keywords(getKeywordTrie())
 {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
     try {
-        /* Initially read in the ode file */
-        readFile();
-
-        /* Initialize the keyword tries for command parsing */
-        initializeTries();
-
-        /* Check for incorrect brackets */
-        checkBrackets();
-
-        /* Remove all comments */
-        removeComments();
-
-        /* Remove unnecessary whitespaces */
-        removeWhitespace();
-
-        /* Expand array descriptions */
-        expandArrays();
-
-        /* Extract exports to dlls */
-        extractExport();
+        /* Skip parsing if the ode file is unchanged since it was cached */
+        if (!config.cacheDirectory.empty()) {
+            const bool loaded = loadCache();
+            if (config.stats) {
+                const double seconds = xppParserStats::elapsed(start);
+                stats.record(LOAD_CACHE, seconds, 0,
+                             loaded ? xppParserStats::definitionCount(*this) : 0,
+                             loaded ? xppParserStats::heapBytes(*this) : 0);
+            }
+            if (loaded) {
+                finishStats(start);
+                return;
+            }
+        }
 
-        /* Extract markov processes */
-        extractMarkov();
+        /* Initially read in the ode file, strip comments and check brackets */
+        readFile();
 
-        /* Extract table definitions */
-        extractTable();
+        if (config.incremental) {
+            /* Split the file into single statements */
+            std::vector<std::size_t> bounds;
+            std::vector<statement> found = splitStatements(bounds);
+            std::vector<parsedChunk> chunks =
+                    splitBlocks(bounds, std::vector<bool>(found.size(), true));
+
+            /* Process the statements and collect them */
+            processChunks(chunks, config.threads);
+            mergeChunks(chunks, &found);
+            statements.swap(found);
+            lines.clear();
+            source.reset();
+        } else {
+            /* Split the file into chunks of complete statements */
+            std::vector<parsedChunk> chunks =
+                    splitChunks(config.threads > 1 ? 4*config.threads : 1);
 
-        /* Extract wiener processes */
-        extractWiener();
+            /* Remove unnecessary whitespaces, expand array descriptions and
+             * extract the definitions of every chunk
+             */
+            processChunks(chunks, config.threads);
 
-        /* Extract globals */
-        extractGlobal();
+            /* Register the names and collect the opts arrays of all chunks */
+            mergeChunks(chunks);
+        }
 
-        /* Extract all other definitions */
-        extractDefinition();
+        /* Store the parsed model for later runs */
+        if (!config.cacheDirectory.empty()) {
+            storeCache();
+        }
+        finishStats(start);
 
         /* Catch errors */
-    } catch (xppParserException& e) {
-        std::cerr << e.what();
-    } catch (std::runtime_error& e) {
-        std::cerr << e.what();
-    } catch (std::exception& e) {
-        std::cerr << e.what();
     } catch (...) {
-        std::cerr << "Unexpected error\n";
-        throw;
+        handleError(std::current_exception(), error);
     }
 }
 
+/**
+ * @brief xppParser::xppParser Constructor of an empty parser for streaming
+ *
+ * @param config The settings of the parser
+ *
+ * The lines are fed to the parser by parseStream.
+ */
+xppParser::xppParser(const xppParserConfig &config)
+    : fileName("<stream>"),
+      config(config),
+      keywords(getKeywordTrie())
+{}
+
 /**
  * @brief xppParser::xppParser Copy constructor of the parser object
  * @param parser The parser object that should be copied
  */
 xppParser::xppParser(const xppParser &parser)
-    : /* Keyword tries */
+    : /* Opts arrays */
+      optsCollection(parser),
+      /* File information */
+      fileName(parser.fileName),
+      config(parser.config),
+      fileSize(parser.fileSize),
+      cacheKey(parser.cacheKey),
+      tableFiles(parser.tableFiles),
+      /* Keyword tries */
       keywords(parser.keywords),
-      options(parser.options),
-      reservedNames(parser.reservedNames),
       usedNames(parser.usedNames),
-      /* Opts arrays */
-      Algebraic(parser.Algebraic),
-      Auxiliar(parser.Auxiliar),
-      Boundaries(parser.Boundaries),
-      Constants(parser.Constants),
-      Equations(parser.Equations),
-      Exports(parser.Exports),
-      Functions(parser.Functions),
-      Globals(parser.Globals),
-      InitConds(parser.InitConds),
-      Temporaries(parser.Temporaries),
-      Markovs(parser.Markovs),
-      Numbers(parser.Numbers),
-      Options(parser.Options),
-      Parameters(parser.Parameters),
-      Special(parser.Special),
-      Sets(parser.Sets),
-      Tables(parser.Tables),
-      Volterra(parser.Volterra),
-      Wieners(parser.Wieners)
+      statements(parser.statements),
+      stats(parser.stats)
+{}
+
+/**
+ * @brief xppParser::xppParser Move constructor of the parser object
+ * @param parser The parser object whose content is taken over
+ *
+ * The opts arrays, the lines and the statements of incremental mode are moved
+ * rather than copied, so handing a large model over costs almost nothing.
+ */
+xppParser::xppParser(xppParser &&parser)
+    : /* Opts arrays */
+      optsCollection(std::move(parser)),
+      /* File information */
+      fileName(parser.fileName),
+      config(parser.config),
+      fileSize(parser.fileSize),
+      cacheKey(parser.cacheKey),
+      tableFiles(std::move(parser.tableFiles)),
+      lines(std::move(parser.lines)),
+      source(std::move(parser.source)),
+      /* Keyword tries */
+      keywords(parser.keywords),
+      usedNames(std::move(parser.usedNames)),
+      statements(std::move(parser.statements)),
+      stats(parser.stats)
 {}
 
 /**
  * @brief Checks whether brackets are closed properly
+ *
+ * @par line: The line that should be checked
+ *
+ * This is the slow path of the bracket check in readFile, which is only taken
+ * to find the exact position of an error.
  */
-void xppParser::checkBrackets() {
+void xppParser::checkBrackets(const lineNumber &line) {
     std::map<char, char> bracketPairs= {std::make_pair(')', '('),
                                         std::make_pair(']', '['),
                                         std::make_pair('}', '{')};
     std::stack<std::pair<char, size_t>> brackets;
-    for (lineNumber line : lines) {
-        auto start = line.first.begin();
-        for (auto it = start; it != line.first.end(); ++it) {
-            switch (*it) {
-            case '(':
-            case '[':
-            case '{':
-                brackets.push(std::make_pair(*it, std::distance(start, it)));
-                break;
-            case ')':
-            case ']':
-            case '}':
-                if (brackets.empty()) {
-                    throw xppParserException(MISSING_OPENING_BRACKET, line,
-                                             std::distance(start, it));
-                } else if (brackets.top().first != bracketPairs[*it]) {
-                    throw xppParserException(MISSING_CLOSING_BRACKET, line,
-                                             brackets.top().second);
-                }
-                brackets.pop();
-                break;
-            default:
-                continue;
+    auto start = line.first.begin();
+    for (auto it = start; it != line.first.end(); ++it) {
+        switch (*it) {
+        case '(':
+        case '[':
+        case '{':
+            brackets.push(std::make_pair(*it, std::distance(start, it)));
+            break;
+        case ')':
+        case ']':
+        case '}':
+            if (brackets.empty()) {
+                throw xppParserException(MISSING_OPENING_BRACKET, line,
+                                         std::distance(start, it));
+            } else if (brackets.top().first != bracketPairs[*it]) {
+                throw xppParserException(MISSING_CLOSING_BRACKET, line,
+                                         brackets.top().second);
             }
+            brackets.pop();
+            break;
+        default:
+            continue;
         }
-        if (!brackets.empty()) {
-            throw xppParserException(MISSING_CLOSING_BRACKET, line,
-                                     brackets.top().second);
-        }
+    }
+    if (!brackets.empty()) {
+        throw xppParserException(MISSING_CLOSING_BRACKET, line,
+                                 brackets.top().second);
     }
 }
 
 /**
- * @brief Checks whether a given name is already taken or reserved
+ * @brief Checks whether a given name is reserved
  *
  * @par name: The name of the new definition
  * @par line: The original line that was parsed from the ode file
  * @par pos: The position of the name in line
+ * @par chunk: The chunk that contains the line
+ *
+ * Whether the name is already taken depends on the preceeding chunks, so the
+ * name is only registered in the chunk and checked when the chunks are merged.
  */
-void xppParser::checkName(const std::string &name, const lineNumber &line, size_t pos) {
-    keywords.setWholeWords(true);
-    if (!usedNames.parseText(name).empty()) {
-        throw xppParserException(DUPLICATED_NAME, line, pos);
-    } else if (!reservedNames.parseText(name).empty()) {
+void xppParser::checkName(const std::string &name, const lineNumber &line,
+                          size_t pos, parsedChunk &chunk) {
+    if (xppReservedNameTable.contains(name)) {
         throw xppParserException(RESERVED_FUNCTION, line, pos);
-    } else if (!keywords.parseText(name).empty()) {
+    } else if (xppKeywordTable.contains(name)) {
         throw xppParserException(RESERVED_KEYWORD, line, pos);
-    } else if (!options.parseText(name).empty()) {
+    } else if (xppOptionNameTable.contains(name)) {
         throw xppParserException(RESERVED_OPTION, line, pos);
     }
-    keywords.setWholeWords(false);
-    usedNames.addString(name);
+    const optsRange *range = chunk.range && chunk.range->Symbolic ?
+                                chunk.range : nullptr;
+    chunk.names.push_back(pendingName{name, &line, pos, true, range});
+}
+
+/**
+ * @brief Checks a name against the already used names
+ *
+ * @par name: The name, for array families the name of a single member
+ * @par pending: The recorded name check
+ *
+ * New definitions must not reuse a name, while references such as initial
+ * conditions must refer to an existing one.
+ */
+void xppParser::declareName(const std::string &name, const pendingName &pending) {
+    /* Statements without a name, e.g. boundary conditions, declare nothing */
+    if (pending.declare) {
+        if (!name.empty() && !usedNames.insert(name).second) {
+            throw xppParserException(DUPLICATED_NAME, *pending.line, pending.pos);
+        }
+    } else if (!usedNames.contains(name)) {
+        throw xppParserException(UNKNOWN_VARIABLE, *pending.line, pending.pos);
+    }
+}
+
+/**
+ * @brief Sets the symbol IDs of all definitions
+ *
+ * @par collection: The opts arrays whose names are looked up
+ */
+void xppParser::resolveSymbols(optsCollection &collection) const {
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        for (opts &opt : collection.*array) {
+            opt.Symbol = usedNames.find(opt.Name);
+        }
+    }
+}
+
+/**
+ * @brief Analyses the index expressions of an array template
+ *
+ * @param text The template line of an array statement.
+ * @param range The array statement, whose Indices are filled.
+ *
+ * Every bracketed expression that is affine in j is recorded together with
+ * the name of the array it refers to. If any expression is not affine the
+ * range is marked accordingly.
+ */
+void xppParser::analyseIndices(const std::string &text, optsRange &range) {
+    size_t pos1 = text.find("[");
+    while (pos1 != std::string::npos) {
+        const size_t pos2 = text.find("]", pos1);
+        if (pos2 == std::string::npos) {
+            range.Affine = false;
+            return;
+        }
+        const xppIndexExpression expr(text.substr(pos1+1, pos2-pos1-1));
+        if (expr.isAffine()) {
+            size_t name = pos1;
+            while (name > 0 && (std::isalnum(static_cast<unsigned char>(text[name-1])) ||
+                                text[name-1] == '_')) {
+                --name;
+            }
+            range.Indices.push_back(optsIndex());
+            optsIndex &index = range.Indices.back();
+            index.Array	 = text.substr(name, pos1-name);
+            index.Stride = expr.stride();
+            index.Offset = expr.offset();
+        } else {
+            range.Affine = false;
+        }
+        pos1 = text.find("[", pos2);
+    }
+}
+
+/**
+ * @brief Returns the end of the statement that starts at a given line
+ *
+ * @par line: The first line of the statement
+ * @par end: The end of the lines
+ *
+ * Most statements consist of a single line. Multi line array statements
+ * "%[start .. end] ... %" and markov processes, which are followed by one line
+ * per state, span multiple lines.
+ */
+std::vector<lineNumber>::const_iterator xppParser::endOfBlock(
+        std::vector<lineNumber>::const_iterator line,
+        std::vector<lineNumber>::const_iterator end) {
+    const xppLineText &text = line->first;
+    if (text.compare(0, 7, "markov ") == 0) {
+        /* The number of states is the third word */
+        std::size_t pos1 = 0, pos2 = 0;
+        getNextWord(*line, pos1, pos2);
+        getNextWord(*line, pos1, pos2);
+        const std::string states = pos2 != std::string::npos ?
+                    getNextWord(*line, pos1, pos2) : std::string();
+        long nstates = std::strtol(states.c_str(), nullptr, 10);
+        ++line;
+        while (nstates-- > 0 && line != end) {
+            ++line;
+        }
+        return line;
+    }
+
+    const std::size_t pos = text.find("[");
+    if (pos != std::string::npos && pos > 0 && text[pos-1] == '%') {
+        ++line;
+        while (line != end) {
+            if (line->first.find("%") != std::string::npos) {
+                return ++line;
+            }
+            ++line;
+        }
+        return line;
+    }
+    return ++line;
 }
 
 /**
@@ -163,9 +358,20 @@ void xppParser::checkName(const std::string &name, const lineNumber &line, size_
  * This function searches for the array expressions found in ode files, that are
  * marked by "x[start .. end]" for single line or "%[start .. end] ... %" for
  * multi line statements. Every array line is duplicated end-start+1 times,
- * while preserving the original order of lines.
+ * while preserving the original order of lines. The expanded lines are
+ * collected in a new vector so that no line has to be shifted around.
+ *
+ * With symbolic arrays, array statements that only contain definitions are
+ * kept as a single template instead. In both cases the lines are registered
+ * as a family of the chunk, together with the index expressions of every
+ * template line.
+ *
+ * @par chunk: The chunk whose lines are expanded
  */
-void xppParser::expandArrays() {
+void xppParser::expandArrays(parsedChunk &chunk) {
+    std::vector<lineNumber> &lines = chunk.lines;
+    std::vector<lineNumber> expandedLines;
+    expandedLines.reserve(lines.size());
     auto line = lines.begin();
     while (line != lines.end()) {
         std::size_t pos1, pos2, pos3;
@@ -204,6 +410,9 @@ void xppParser::expandArrays() {
             if (line->first.substr(pos1-1, 1) == "%") {
                 /* Multiline statements end with a line with a single "%" */
                 while (true) {
+                    if (line2 == lines.end()) {
+                        throw xppParserException(WRONG_ARRAY_ASSIGNMENT, *line, pos1-1);
+                    }
                     size_t endArray = line2->first.find("%");
                     if (endArray != std::string::npos) {
                         ++line2;
@@ -217,533 +426,967 @@ void xppParser::expandArrays() {
                 /* Change the first bracket to [j] to unify expression handling
                  * with the multiline case.
                  */
-                arrayExpressions[0].first.replace(pos1, pos3, "[j]");
+                std::string expr = arrayExpressions[0].first.str();
+                expr.replace(pos1, pos3-pos1+1, "[j]");
+                arrayExpressions[0].first.assign(std::move(expr));
             }
-            lines.erase(line, line2);
 
-            /* Expand the array expressions and insert it*/
-            std::vector<lineNumber> arrayLines;
-            arrayLines.reserve(end-start+1);
-            for (int j = start; j <= end; j++) {
-                expandArrayLines(arrayLines, arrayExpressions, j);
+            /* Statements other than definitions are always expanded */
+            bool symbolic = config.symbolicArrays;
+            for (const lineNumber &expr : arrayExpressions) {
+                const std::string key = expr.first.substr(0, expr.first.find(" "));
+                symbolic = symbolic && key != "markov" && key != "table" &&
+                           key != "wiener" && key != "global" &&
+                           key != "export" && key != "number" && key != "@";
             }
-            lines.insert(line, arrayLines.begin(), arrayLines.end());
+
+            /* Analyse the index expressions of the templates */
+            arrayFamily family;
+            family.first = expandedLines.size();
+            for (const lineNumber &expr : arrayExpressions) {
+                family.templates.push_back(optsRange());
+                optsRange &range = family.templates.back();
+                range.Line	   = line->second;
+                range.Start	   = start;
+                range.End	   = end;
+                range.Symbolic = symbolic;
+                analyseIndices(expr.first.str(), range);
+            }
+
+            if (symbolic) {
+                /* Keep the templates together with the index range */
+                expandedLines.insert(expandedLines.end(),
+                                     std::make_move_iterator(arrayExpressions.begin()),
+                                     std::make_move_iterator(arrayExpressions.end()));
+            } else {
+                /* Expand the array expressions and append them */
+                expandArrayLines(expandedLines, arrayExpressions, start, end);
+            }
+            family.last = expandedLines.size();
+            if (family.last != family.first) {
+                chunk.families.push_back(std::move(family));
+            }
+            line = line2;
         } else {
+            expandedLines.push_back(std::move(*line));
             ++line;
         }
     }
+    lines.swap(expandedLines);
 }
 
 /**
- * @brief Inserts a given array expression into the ode list for given j
+ * @brief Inserts the given array expressions into the ode list for a range of j
  *
  * @param lines A vector that is to be filled with the resulting lines.
  * @param expressions A vector containing the individual lines of array
  *		  expressions.
- * @param idx The index that should be used for evaluation of the expressions.
+ * @param start The first index of the array.
+ * @param end The last index of the array.
  *
  * This function takes the array expressions and replaces every assignment of
- * type [...] with the evaluated expression for j=idx. Afterwards the resulting
- * line is inserted into the provided vector.
+ * type [...] with the evaluated expression for every j in [start, end]. The
+ * resulting lines are appended index by index to the provided vector.
+ *
+ * Every bracket is compiled only once and evaluated for the whole range, so
+ * that only the lines themselves have to be assembled for every index.
  */
 void xppParser::expandArrayLines(std::vector<lineNumber>& lines,
                                  const std::vector<lineNumber>& expressions,
-                                 const int idx) {
-    /* Initialize the parser with the variable "j" */
+                                 const int start, const int end) {
+    if (end < start) {
+        return;
+    }
+
+    /* Split the expressions into the text between the brackets and the
+     * values of the brackets for every index
+     */
+    std::vector<stringList> pieces(expressions.size());
+    std::vector<std::vector<long long>> values;
+    for (std::size_t i = 0; i < expressions.size(); ++i) {
+        const lineNumber &expr = expressions[i];
+        size_t pos = 0;
+        size_t pos1 = expr.first.find("[");
+        while (pos1 != std::string::npos) {
+            const size_t pos2 = expr.first.find("]", pos1);
+            pieces[i].push_back(expr.first.substr(pos, pos1-pos));
+            values.push_back(std::vector<long long>());
+            evaluateIndices(expr.first.substr(pos1+1, pos2-pos1-1), expr, pos1,
+                            start, end, values.back());
+            pos = pos2+1;
+            pos1 = expr.first.find("[", pos);
+        }
+        pieces[i].push_back(expr.first.substr(pos));
+    }
+
+    /* Assemble the lines */
+    for (std::size_t j = 0; j <= std::size_t(end - start); ++j) {
+        std::size_t index = 0;
+        for (std::size_t i = 0; i < expressions.size(); ++i) {
+            std::string line = pieces[i].front();
+            for (std::size_t k = 1; k < pieces[i].size(); ++k) {
+                line += std::to_string(values[index++][j]);
+                line += pieces[i][k];
+            }
+            lines.push_back(std::make_pair(std::move(line), expressions[i].second));
+        }
+    }
+}
+
+/**
+ * @brief Evaluates an index expression for a range of j
+ *
+ * @param expr The expression within the brackets.
+ * @param line The line of the expression, which is used for error messages.
+ * @param pos The position of the opening bracket in line.
+ * @param start The first index.
+ * @param end The last index.
+ * @param values The values of the expression for j = start, ..., end.
+ *
+ * The expression is compiled by xppIndexExpression. Only expressions it does
+ * not support, e.g. function calls, are evaluated by muparserx.
+ */
+void xppParser::evaluateIndices(const std::string &expr, const lineNumber &line,
+                                size_t pos, int start, int end,
+                                std::vector<long long> &values) {
+    const xppIndexExpression index(expr);
+    if (index.isCompiled()) {
+        if (!index.evaluate(start, end, values)) {
+            throw xppParserException(WRONG_ARRAY_ASSIGNMENT, line, pos+1);
+        }
+        return;
+    }
+
     mup::ParserX parser;
-    mup::Value j((mup::int_type)idx);
-    mup::Value result;
+    mup::Value j((mup::int_type)start);
     parser.DefineVar("j",  mup::Variable(&j));
-    for (const lineNumber &expr : expressions) {
-        lineNumber temp = expr;
-        size_t pos1 = temp.first.find("[");
-        size_t pos2 = temp.first.find("]");
-        while (pos1 != std::string::npos) {
-            /* Evaluate the expression within the brackets and replace the
-             * brackets with the result.
-             */
-            parser.SetExpr(temp.first.substr(pos1+1, pos2-pos1-1));
-            result = parser.Eval();
+    parser.SetExpr(expr);
+    values.clear();
+    for (int idx = start; idx <= end; ++idx) {
+        j = (mup::int_type)idx;
+        const mup::Value result = parser.Eval();
+
+        /* Check whether the result is an integer */
+        if (result.GetType() != 'i') {
+            throw xppParserException(WRONG_ARRAY_ASSIGNMENT, line, pos+1);
+        }
+        values.push_back(result.GetInteger());
+    }
+}
+
+/**
+ * @brief Evaluates the index expressions of an array template
+ *
+ * @param text The template that contains index expressions in brackets.
+ * @param line The line of the template, which is used for error messages.
+ * @param start The first value of j.
+ * @param end The last value of j.
+ *
+ * Every bracket is compiled only once and evaluated for the whole range.
+ *
+ * @return The text for every j in [start, end], where every bracketed
+ * expression is replaced by its value
+ */
+stringList xppParser::expandIndices(const std::string &text,
+                                    const lineNumber &line, int start, int end) {
+    if (end < start) {
+        return stringList();
+    }
+
+    /* Split the template into the text between the brackets and the values
+     * of the brackets
+     */
+    stringList pieces;
+    std::vector<std::vector<long long>> values;
+    size_t pos = 0;
+    size_t pos1 = text.find("[");
+    while (pos1 != std::string::npos) {
+        const size_t pos2 = text.find("]", pos1);
+        pieces.push_back(text.substr(pos, pos1-pos));
+        values.push_back(std::vector<long long>());
+        evaluateIndices(text.substr(pos1+1, pos2-pos1-1), line, pos1, start, end,
+                        values.back());
+        pos = pos2+1;
+        pos1 = text.find("[", pos);
+    }
+    pieces.push_back(text.substr(pos));
+
+    stringList expanded(std::size_t(end - start) + 1, pieces.front());
+    for (std::size_t j = 0; j < expanded.size(); ++j) {
+        for (std::size_t k = 1; k < pieces.size(); ++k) {
+            expanded[j] += std::to_string(values[k-1][j]);
+            expanded[j] += pieces[k];
+        }
+    }
+    return expanded;
+}
+
+/**
+ * @brief Expands the symbolic array families of an opts array
+ *
+ * @param array The opts array that may contain symbolic array families.
+ *
+ * @return The opts array with one definition per index of every family
+ *
+ * The templates of a family are expanded for its whole range at once, so that
+ * every bracket is compiled only once. The definitions are then collected
+ * index by index, so that the result has the same order as if the array
+ * statement had been expanded while parsing.
+ */
+optsArray xppParser::expandArray(const optsArray &array) {
+    optsArray expanded;
+    expanded.reserve(array.size());
+    auto opt = array.cbegin();
+    while (opt != array.cend()) {
+        if (!opt->isSymbolic()) {
+            expanded.push_back(opts(*opt));
+            ++opt;
+            continue;
+        }
+        auto last = opt;
+        while (last != array.cend() && last->isSymbolic() &&
+               last->Range.Line == opt->Range.Line) {
+            ++last;
+        }
+        /* Expand the templates of every member for the whole range */
+        const int start = opt->Range.Start;
+        const int end = opt->Range.End;
+        std::vector<stringList> names, exprs;
+        std::vector<std::vector<stringList>> args;
+        for (auto member = opt; member != last; ++member) {
+            names.push_back(expandIndices(member->Name,
+                                          lineNumber(xppLineText(member->Name.data(),
+                                                                 member->Name.size()),
+                                                     member->Line),
+                                          start, end));
+            exprs.push_back(expandIndices(member->Expr,
+                                          lineNumber(xppLineText(member->Expr.data(),
+                                                                 member->Expr.size()),
+                                                     member->Line),
+                                          start, end));
+            args.push_back(std::vector<stringList>());
+            for (const std::string &arg : member->Args) {
+                args.back().push_back(expandIndices(arg,
+                                                    lineNumber(xppLineText(arg.data(), arg.size()),
+                                                               member->Line),
+                                                    start, end));
+            }
+        }
 
-            /* Check whether the result is an integer */
-            if (result.GetType() != 'i') {
-                throw xppParserException(WRONG_ARRAY_ASSIGNMENT, expr, pos1+1);
+        for (int idx = start; idx <= end; ++idx) {
+            const std::size_t j = std::size_t(idx - start);
+            for (auto member = opt; member != last; ++member) {
+                const std::size_t m = std::size_t(member - opt);
+                opts result(member->Line);
+                result.Range		  = member->Range;
+                result.Range.Index	  = idx;
+                result.Range.Symbolic = false;
+                result.Name = std::move(names[m][j]);
+                result.Expr = std::move(exprs[m][j]);
+                result.Args.reserve(args[m].size());
+                for (stringList &arg : args[m]) {
+                    result.Args.push_back(std::move(arg[j]));
+                }
+                expanded.push_back(std::move(result));
             }
-            temp.first.replace(pos1, pos2-pos1+1, result.ToString());
+        }
+        opt = last;
+    }
+    return expanded;
+}
 
-            pos1 = temp.first.find("[", pos2);
-            pos2 = temp.first.find("]", pos1);
+/**
+ * @brief Expands the symbolic array families of all opts arrays
+ *
+ * Only the arrays that contain symbolic families are rebuilt. Afterwards the
+ * expanded definitions get the symbol IDs of their names.
+ */
+void xppParser::expandSymbolicArrays(void) {
+    bool expanded = false;
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        optsArray &target = this->*array;
+        if (std::any_of(target.cbegin(), target.cend(),
+                        [](const opts &opt) {return opt.isSymbolic();})) {
+            target = expandArray(target);
+            expanded = true;
         }
-        lines.push_back(temp);
+    }
+
+    /* The members of the families refer to their own names */
+    if (expanded) {
+        resolveSymbols(*this);
     }
 }
 
 /**
  * @brief Extract definitions from the ode file
  *
+ * @par line: The line containing the definitions
+ * @par chunk: The chunk that contains the line
+ *
  * This extracts definitions that are given in the keyword list and are marked
  * by an equal sign.
  */
-void xppParser::extractDefinition(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        /* Search for the first keyword. In most cases it should be the first
-         * consecutive string that precedes a whitespace or equal sign.
+void xppParser::extractDefinition(const lineNumber &line, parsedChunk &chunk) {
+    /* Search for the first keyword. In most cases it should be the first
+     * consecutive string that precedes a whitespace or equal sign.
+     */
+    std::size_t pos1 = 0, pos2 = 0;
+    std::string key = getNextWord(line, pos1, pos2);
+    if (pos2 == std::string::npos) {
+        throw xppParserException(UNKNOWN_ASSIGNMENT, line, pos1+1);
+    }
+    /* Search for keywords */
+    auto res = keywordSearch(key, line.first, pos2);
+
+    while (pos2 != std::string::npos) {
+        opts opt(line.second);
+
+        switch (res.id) {
+        case 0: /* !Name */
+            opt.Name = line.first.substr(pos1+1, pos2-pos1-1);
+            break;
+        case 1:  /* Name(t+1) */
+        case 2:  /* Name' */
+        case 4:  /* Name(t) */
+        case 11: /* Name(0) */
+            opt.Name = line.first.substr(pos1, res.start);
+            break;
+        case 3: /* dName/dt */
+            opt.Name = line.first.substr(pos1+1, res.start-1);
+            break;
+        case 9: {/* Name(args...) */
+            size_t pos3 = line.first.find("(", pos1);
+            opt.Name = line.first.substr(pos1, pos3-pos1);
+            opt.Args = getList(line, pos3, pos2, ')', ',');
+            break;
+        }
+        case 12:
+            break;
+        case 13: /* 0=Expression */
+            opt.Name = "Initial Condition";
+            break;
+        case 19: /* Name=Expression */
+            opt.Name = line.first.substr(pos1, pos2-pos1);
+            break;
+        default: /* keyword Name */
+            opt.Name = getNextWord(line, pos1, pos2);
+            break;
+        }
+
+        /* Check whether the name is already taken/reserved, except for
+         * initial conditions, where we check for existence. Also check
+         * whether a given option is valid.
          */
-        std::size_t pos1 = 0, pos2 = 0;
-        std::string key = getNextWord(*line, pos1, pos2);
-        if (pos2 == std::string::npos) {
-            throw xppParserException(UNKNOWN_ASSIGNMENT, *line, pos1+1);
-        }
-        /* Search for keywords */
-        auto res = keywordSearch(key, line->first.at(pos2));
-
-        while (pos2 != std::string::npos) {
-            opts opt(line->second);
-
-            switch (res.id) {
-            case 0: /* !Name */
-                opt.Name = line->first.substr(pos1+1, pos2-pos1-1);
-                break;
-            case 1:  /* Name(t+1) */
-            case 2:  /* Name' */
-            case 4:  /* Name(t) */
-            case 11: /* Name(0) */
-                opt.Name = line->first.substr(pos1, res.start);
-                break;
-            case 3: /* dName/dt */
-                opt.Name = line->first.substr(pos1+1, res.start-1);
-                break;
-            case 9: {/* Name(args...) */
-                size_t pos3 = line->first.find("(", pos1);
-                opt.Name = line->first.substr(pos1, pos3-pos1);
-                opt.Args = getList(line->first.substr(pos3, pos2-pos3),
-                                   opt.Line, ")", ",");
-                break;
-            }
-            case 12:
-                break;
-            case 13: /* 0=Expression */
-                opt.Name = "Initial Condition";
-                break;
-            case 19: /* Name=Expression */
-                opt.Name = line->first.substr(pos1, pos2-pos1);
-                break;
-            default: /* keyword Name */
-                opt.Name = getNextWord(*line, pos1, pos2);
-                break;
-            }
-
-            /* Check whether the name is already taken/reserved, except for
-             * initial conditions, where we check for existence. Also check
-             * whether a given option is valid.
-             */
-            if (res.id != 10 &&
-                res.id != 17) {
-                checkName(opt.Name, *line, pos1);
-            } else if (res.id == 10) {
-                if (usedNames.parseText(opt.Name).empty()) {
-                    throw xppParserException(UNKNOWN_VARIABLE, *line, pos1);
-                }
-            } else if (res.id == 17) {
-                if (options.parseText(opt.Name).empty()) {
-                    throw xppParserException(UNKNOWN_OPTION, *line, pos1);
-                }
-                /* Turn the name to upper case to simplify further handling */
-                for (char &c : opt.Name) {
-                    c = std::toupper(c);
-                }
+        if (res.id != 10 &&
+            res.id != 17) {
+            checkName(opt.Name, line, pos1, chunk);
+        } else if (res.id == 10) {
+            const optsRange *range = chunk.range && chunk.range->Symbolic ?
+                                        chunk.range : nullptr;
+            chunk.names.push_back(pendingName{opt.Name, &line, pos1, false,
+                                               range});
+        } else if (res.id == 17) {
+            if (!xppOptionNameTable.contains(opt.Name)) {
+                throw xppParserException(UNKNOWN_OPTION, line, pos1);
             }
+            /* Turn the name to upper case to simplify further handling */
+            for (char &c : opt.Name) {
+                c = std::toupper(c);
+            }
+        }
 
-            /* Get the expression */
-            opt.Expr = getNextExpr(*line, pos1, pos2);
-
-            /* Check numbers are indeed numeric expressions */
-            if (res.id == 8 ||
-                (res.id == 17 &&
-                 opt.Name != "OUTPUT" &&
-                 opt.Name != "LOGFILE" &&
-                 opt.Name != "METH")) {
-                if (!isNumeric(opt.Expr)) {
-                    throw xppParserException(EXPECTED_NUMBER, *line, pos1);
-                }
-                /* Check if all function arguments are used */
-            } else if (res.id == 9) {
-                size_t pos3 = opt.Name.length()+1;
-                for (std::string &str : opt.Args) {
-                    if (opt.Expr.find(str) == std::string::npos) {
-                        throw xppParserException(MISSING_ARGUMENT, *line, pos3);
-                    }
-                    pos3 += str.length()+1;
+        /* Get the expression */
+        opt.Expr = getNextExpr(line, pos1, pos2);
+
+        /* Check numbers are indeed numeric expressions */
+        if (res.id == 8 ||
+            (res.id == 17 &&
+             opt.Name != "OUTPUT" &&
+             opt.Name != "LOGFILE" &&
+             opt.Name != "METH")) {
+            if (!isNumeric(opt.Expr)) {
+                throw xppParserException(EXPECTED_NUMBER, line, pos1);
+            }
+            /* Check if all function arguments are used */
+        } else if (res.id == 9) {
+            size_t pos3 = opt.Name.length()+1;
+            for (std::string &str : opt.Args) {
+                if (opt.Expr.find(str) == std::string::npos) {
+                    throw xppParserException(MISSING_ARGUMENT, line, pos3);
                 }
+                pos3 += str.length()+1;
             }
+        }
 
-            /* Find the type of the keyword */
-            switch(res.id) {
-            case 0:
-                Constants.push_back(opt);
-                break;
-            case 1:
-            case 2:
-            case 3:
-                Equations.push_back(opt);
-                break;
-            case 4:
-                Volterra.push_back(opt);
-                break;
-            case 5:
-                Constants.push_back(opt);
-                break;
-            case 6:
-                Auxiliar.push_back(opt);
-                break;
-            case 7:
-                Parameters.push_back(opt);
-                break;
-            case 8:
-                Numbers.push_back(opt);
-                break;
-            case 9:
-                Functions.push_back(opt);
-                break;
-            case 10:
-                InitConds.push_back(opt);
-                break;
-            case 11:
-                Volterra.push_back(opt);
-                break;
-            case 12:
-                /* Boundary expressions do not have a name */
-                opt.Expr = opt.Name;
-                opt.Name = "";
-                Boundaries.push_back(opt);
-                break;
-            case 13:
-                Volterra.push_back(opt);
-                break;
-            case 14:
-                Algebraic.push_back(opt);
-                break;
-            case 15:
-                /* Extract the argument list */
-                pos1 = opt.Expr.find("(");
-                opt.Args = getList(opt.Expr.substr(pos1), opt.Line, ")", ",");
-                opt.Expr.resize(pos1);
-                Special.push_back(opt);
-                break;
-            case 16:
-                /* Sets are a comma separated list */
-                opt.Args = getList(opt.Expr, opt.Line, "}", ",");
-                opt.Expr = "";
-                Sets.push_back(opt);
-                break;
-            case 17:
-                Options.push_back(opt);
-                break;
-            case 18:
-                Exports.push_back(opt);
-                break;
-            case 19:
-                Temporaries.push_back(opt);
-                break;
-            default:
-                throw xppParserException(UNKNOWN_ASSIGNMENT, *line, pos1+1);
-                break;
-            }
-        }
-        lines.erase(line);
+        /* Find the type of the keyword */
+        switch(res.id) {
+        case 0:
+            chunk.Constants.push_back(opt);
+            break;
+        case 1:
+        case 2:
+        case 3:
+            chunk.Equations.push_back(opt);
+            break;
+        case 4:
+            chunk.Volterra.push_back(opt);
+            break;
+        case 5:
+            chunk.Constants.push_back(opt);
+            break;
+        case 6:
+            chunk.Auxiliar.push_back(opt);
+            break;
+        case 7:
+            chunk.Parameters.push_back(opt);
+            break;
+        case 8:
+            chunk.Numbers.push_back(opt);
+            break;
+        case 9:
+            chunk.Functions.push_back(opt);
+            break;
+        case 10:
+            chunk.InitConds.push_back(opt);
+            break;
+        case 11:
+            chunk.Volterra.push_back(opt);
+            break;
+        case 12:
+            /* Boundary expressions do not have a name */
+            opt.Expr = opt.Name;
+            opt.Name = "";
+            chunk.Boundaries.push_back(opt);
+            break;
+        case 13:
+            chunk.Volterra.push_back(opt);
+            break;
+        case 14:
+            chunk.Algebraic.push_back(opt);
+            break;
+        case 15: {
+            /* Extract the argument list */
+            pos1 = opt.Expr.find("(");
+            const lineNumber args(opt.Expr.substr(pos1), opt.Line);
+            opt.Args = getList(args, 0, args.first.size(), ')', ',');
+            opt.Expr.resize(pos1);
+            chunk.Special.push_back(opt);
+            break;
+        }
+        case 16:
+            /* Sets are a comma separated list */
+            opt.Args = getList(lineNumber(opt.Expr, opt.Line), 0, opt.Expr.size(),
+                               '}', ',');
+            opt.Expr = "";
+            chunk.Sets.push_back(opt);
+            break;
+        case 17:
+            chunk.Options.push_back(opt);
+            break;
+        case 18:
+            chunk.Exports.push_back(opt);
+            break;
+        case 19:
+            chunk.Temporaries.push_back(opt);
+            break;
+        default:
+            throw xppParserException(UNKNOWN_ASSIGNMENT, line, pos1+1);
+            break;
+        }
     }
 }
 
 /**
  * @brief Extract exports to link to procompiled C routines inside xppaut
  *
+ * @par line: The line containing the export statement
+ * @par chunk: The chunk that contains the line
+ *
  * This function extracts the in and out arguments of the respective function.
  * To keep with the other structures the Args vector contains both the input and
  * the output. Therefore the Expr string contains the number of input arguments.
  */
-void xppParser::extractExport(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("export");
-        std::size_t pos2 = line->first.find(" ", pos1);
-        if (pos1 != std::string::npos) {
-            opts opt(line->second);
-            opt.Args = getList(getNextWord(*line, pos1, pos2), opt.Line, "}", ",");;
-            opt.Expr = std::to_string(opt.Args.size());
+void xppParser::extractExport(const lineNumber &line, parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(line, pos1, pos2);
 
-            stringList temp = getList(getNextWord(*line, pos1, pos2), opt.Line, "}", ",");
-            opt.Args.insert(opt.Args.end(), temp.begin(), temp.end());
+    opts opt(line.second);
+    getNextWord(line, pos1, pos2);
+    opt.Args = getList(line, pos1, std::min(pos2, line.first.size()), '}', ',');
+    opt.Expr = std::to_string(opt.Args.size());
 
-            Exports.push_back(opt);
-            lines.erase(line);
-        } else {
-            ++line;
-        }
-    }
+    getNextWord(line, pos1, pos2);
+    stringList temp = getList(line, pos1, std::min(pos2, line.first.size()), '}', ',');
+    opt.Args.insert(opt.Args.end(), temp.begin(), temp.end());
+
+    chunk.Exports.push_back(opt);
 }
 
 /**
  * @brief Extract a global flag implementing a delta function
  *
+ * @par line: The line containing the global statement
+ * @par chunk: The chunk that contains the line
+ *
  * This function extracts the condition, the sign of the flag and the resets
  */
-void xppParser::extractGlobal(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("global");
-        std::size_t pos2 = line->first.find(" ", pos1);
-        if (pos1 != std::string::npos) {
-            opts opt(line->second);
+void xppParser::extractGlobal(const lineNumber &line, parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(line, pos1, pos2);
 
-            /* Parse the sign flag. For simplicity store it in the name slot */
-            opt.Name = getNextWord(*line, pos1, pos2);
+    opts opt(line.second);
 
-            /* Parse flip condition. */
-            pos1 = line->first.find_first_not_of(" ", pos2);
-            pos2 = line->first.find("{", pos1);
-            opt.Expr = line->first.substr(pos1, pos2-pos1-1);
+    /* Parse the sign flag. For simplicity store it in the name slot */
+    opt.Name = getNextWord(line, pos1, pos2);
 
-            /* The individual resets are separated by a semicolon */
-            opt.Args = getList(line->first.substr(pos2), opt.Line, "}", ";");
-            Globals.push_back(opt);
-            lines.erase(line);
-        } else {
-            ++line;
-        }
+    /* Parse flip condition. */
+    pos1 = line.first.find_first_not_of(" ", pos2);
+    pos2 = line.first.find("{", pos1);
+    opt.Expr = line.first.substr(pos1, pos2-pos1-1);
+
+    /* The individual resets are separated by a semicolon */
+    if (pos2 == std::string::npos) {
+        throw xppParserException(EXPECTED_LIST_ARGUMENT, line, pos1);
     }
+    opt.Args = getList(line, pos2, line.first.size(), '}', ';');
+    chunk.Globals.push_back(opt);
 }
 
 /**
- * @brief Extract a markov process from the parsed lines
+ * @brief Links a function library into the ode file
  *
- * This function extracts the definition of markov processes as they constitute
- * one of the few multiline statements in an ode file.
+ * @par line: The line containing the library statement
+ * @par chunk: The chunk that contains the line
+ *
+ * The statement "library file" adds all functions of the given ode file as if
+ * they were defined at this line. The library is parsed only once and its
+ * functions are copied without tokenising them again.
  */
-void xppParser::extractMarkov(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("markov");
-        std::size_t pos2 = line->first.find(" ", pos1);
-        if (pos1 != std::string::npos) {
-            opts opt(line->second);
+void xppParser::extractLibrary(const lineNumber &line, parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(line, pos1, pos2);
+    const std::string fn = getNextWord(line, pos1, pos2);
+    if (fn.empty() || pos2 != std::string::npos) {
+        throw xppParserException(UNKNOWN_ASSIGNMENT, line, pos1);
+    }
 
-            opt.Name = getNextWord(*line, pos1, pos2);
-            checkName(opt.Name, *line, pos1);
+    const std::shared_ptr<const parsedLibrary> library = loadLibrary(fn);
+    chunk.Functions.reserve(chunk.Functions.size() + library->functions.size());
+    for (const opts &function : library->functions) {
+        chunk.Functions.push_back(opts(function));
+        chunk.Functions.back().Line = line.second;
+        chunk.names.push_back(pendingName{function.Name, &line, pos1, true, nullptr});
+    }
 
-            /* Parse the number of states */
-            int nstates;
-            try {
-                nstates = std::stoi(getNextWord(*line, pos1, pos2));
-            } catch (std::invalid_argument) {
-                throw xppParserException(EXPECTED_NUMBER, *line, pos1);
-            }
-            opt.Expr = nstates;
-
-            /* Parse the transition probabilities */
-            opt.Args.reserve(nstates*nstates);
-            for (int i=0; i < nstates; i++) {
-                auto line2 = std::next(line);
-                pos2 = 0;
-                for (int j=0; j < nstates; j++) {
-                    pos1 = line2->first.find("{", pos2);
-                    pos2 = line2->first.find("}", pos1);
-                    if (pos1 == std::string::npos) {
-                        throw xppParserException(MISSING_MARKOV_ASSIGNMENT,
-                                                 *line2, pos2);
-                    }
-                    opt.Args.push_back(line2->first.substr(pos1+1, pos2-pos1-1));
+    /* The model depends on the files of nested libraries as well */
+    chunk.tableFiles.push_back(fn);
+    chunk.tableFiles.insert(chunk.tableFiles.end(), library->tableFiles.begin(),
+                            library->tableFiles.end());
+}
+
+/**
+ * @brief Classifies every line and passes it to the respective extractor
+ *
+ * @par chunk: The chunk whose lines are extracted
+ *
+ * The statement type of a line is determined by its first word. This is done
+ * in a single pass over all lines, so that the extractors only append to the
+ * opts arrays and no line has to be removed from the middle of the vector.
+ * Multiline statements like markov processes advance the iterator themselves.
+ */
+void xppParser::extractLines(parsedChunk &chunk) {
+    const optsCollection::arrayList &arrays = optsCollection::arrays();
+    std::array<std::size_t, std::tuple_size<optsCollection::arrayList>::value> sizes;
+    auto family = chunk.families.cbegin();
+    for (auto line = chunk.lines.cbegin(); line != chunk.lines.cend(); ++line) {
+        /* Determine whether the line stems from an array statement */
+        const std::size_t index = std::distance(chunk.lines.cbegin(), line);
+        while (family != chunk.families.cend() && family->last <= index) {
+            ++family;
+        }
+        chunk.range = nullptr;
+        optsRange member;
+        if (family != chunk.families.cend() && family->first <= index) {
+            const std::size_t offset = index - family->first;
+            const std::size_t count  = family->templates.size();
+            chunk.range = &family->templates[offset % count];
+            member = *chunk.range;
+            if (!member.Symbolic) {
+                member.Index = member.Start + static_cast<int>(offset / count);
+            }
+        }
+        if (chunk.range || chunk.stats) {
+            for (std::size_t i = 0; i < arrays.size(); ++i) {
+                sizes[i] = (chunk.*arrays[i]).size();
+            }
+        }
+
+        const auto first = line;
+        const std::size_t wieners = chunk.Wieners.Args.size();
+        const xppParserStats::clock::time_point start = xppParserStats::start(chunk.stats);
+        xppPhase phase = EXTRACT_DEFINITION;
+        std::size_t pos1 = 0, pos2 = 0;
+        const std::string key = getNextWord(*line, pos1, pos2);
+        if (key == "export") {
+            phase = EXTRACT_EXPORT;
+            extractExport(*line, chunk);
+        } else if (key == "markov") {
+            phase = EXTRACT_MARKOV;
+            extractMarkov(line, chunk);
+        } else if (key == "table") {
+            phase = EXTRACT_TABLE;
+            extractTable(*line, chunk);
+        } else if (key == "wiener") {
+            phase = EXTRACT_WIENER;
+            extractWiener(*line, chunk);
+        } else if (key == "global") {
+            phase = EXTRACT_GLOBAL;
+            extractGlobal(*line, chunk);
+        } else if (key == "library" && pos2 != std::string::npos &&
+                   line->first[pos2] == ' ') {
+            phase = EXTRACT_LIBRARY;
+            extractLibrary(*line, chunk);
+        } else {
+            extractDefinition(*line, chunk);
+        }
+
+        /* Count the lines that were read and the definitions they produced */
+        if (chunk.stats) {
+            const double seconds = xppParserStats::elapsed(start);
+            std::size_t definitions = chunk.Wieners.Args.size() - wieners;
+            std::size_t bytes = 0;
+            for (std::size_t j = wieners; j < chunk.Wieners.Args.size(); ++j) {
+                bytes += sizeof(std::string) +
+                         xppParserStats::heapBytes(chunk.Wieners.Args[j]);
+            }
+            for (std::size_t i = 0; i < arrays.size(); ++i) {
+                const optsArray &array = chunk.*arrays[i];
+                definitions += array.size() - sizes[i];
+                for (std::size_t j = sizes[i]; j < array.size(); ++j) {
+                    bytes += xppParserStats::heapBytes(array[j]);
                 }
-                if (pos2 != line2->first.size()-1) {
-                    throw xppParserException(WRONG_MARKOV_ASSIGNMENT,
-                                             *line2, line2->first.size());
+            }
+            chunk.stats->record(phase, seconds, std::distance(first, line) + 1,
+                                definitions, bytes);
+        }
+
+        /* Attach the array statement to the extracted definitions */
+        if (chunk.range) {
+            for (std::size_t i = 0; i < arrays.size(); ++i) {
+                optsArray &array = chunk.*arrays[i];
+                for (std::size_t j = sizes[i]; j < array.size(); ++j) {
+                    array[j].Range = member;
                 }
-                lines.erase(line2);
             }
-            Markovs.push_back(opt);
-            lines.erase(line);
-        } else {
-            ++line;
         }
     }
+    chunk.range = nullptr;
+}
+
+/**
+ * @brief Extract a markov process from the parsed lines
+ *
+ * @par line: Iterator to the line containing the markov statement. It is
+ * advanced to the last row of the transition matrix.
+ * @par chunk: The chunk that contains the line
+ *
+ * This function extracts the definition of markov processes as they constitute
+ * one of the few multiline statements in an ode file.
+ */
+void xppParser::extractMarkov(std::vector<lineNumber>::const_iterator &line,
+                              parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(*line, pos1, pos2);
+
+    opts opt(line->second);
+
+    opt.Name = getNextWord(*line, pos1, pos2);
+    checkName(opt.Name, *line, pos1, chunk);
+
+    /* Parse the number of states */
+    int nstates;
+    try {
+        nstates = std::stoi(getNextWord(*line, pos1, pos2));
+    } catch (std::invalid_argument) {
+        throw xppParserException(EXPECTED_NUMBER, *line, pos1);
+    }
+    opt.Expr = nstates;
+
+    /* Parse the transition probabilities */
+    opt.Args.reserve(nstates*nstates);
+    auto line2 = line;
+    for (int i=0; i < nstates; i++) {
+        if (std::next(line2) == chunk.lines.cend()) {
+            throw xppParserException(MISSING_MARKOV_ASSIGNMENT,
+                                     *line2, line2->first.size());
+        }
+        ++line2;
+        pos2 = 0;
+        for (int j=0; j < nstates; j++) {
+            pos1 = line2->first.find("{", pos2);
+            pos2 = line2->first.find("}", pos1);
+            if (pos1 == std::string::npos) {
+                throw xppParserException(MISSING_MARKOV_ASSIGNMENT,
+                                         *line2, pos2);
+            }
+            opt.Args.push_back(line2->first.substr(pos1+1, pos2-pos1-1));
+        }
+        if (pos2 != line2->first.size()-1) {
+            throw xppParserException(WRONG_MARKOV_ASSIGNMENT,
+                                     *line2, line2->first.size());
+        }
+    }
+    chunk.Markovs.push_back(opt);
+    line = line2;
 }
 
 /**
  * @brief Extract a table
  *
+ * @par line: The line containing the table statement
+ * @par chunk: The chunk that contains the line
+ *
  * This function extracts a precomputed table either from a file or calculates
  * it from the definition.
  */
-void xppParser::extractTable(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("table");
-        std::size_t pos2 = line->first.find(" ", pos1);
-        if (pos1 != std::string::npos) {
-            opts opt(line->second);
+void xppParser::extractTable(const lineNumber &line, parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(line, pos1, pos2);
 
-            unsigned npoints;
-            double xLow, xHigh;
+    opts opt(line.second);
 
-            /* Initialize the parser */
-            mup::ParserX parser;
+    unsigned npoints;
+    double xLow, xHigh;
 
-            /* Parse the name */
-            opt.Name = getNextWord(*line, pos1, pos2);
-            checkName(opt.Name, *line, pos1);
+    /* Initialize the parser */
+    mup::ParserX parser;
 
-            /* If the table has to be calculated there is a % sign instead of a
-             * filename
-             */
-            std::string fn = getNextWord(*line, pos1, pos2);
-            if (fn == "%") {
-                /* Get the number of points */
-                try {
-                    npoints = std::stoi(getNextWord(*line, pos1, pos2));
-                } catch (std::invalid_argument) {
-                    throw xppParserException(EXPECTED_NUMBER, *line, pos1);
+    /* Parse the name */
+    opt.Name = getNextWord(line, pos1, pos2);
+    checkName(opt.Name, line, pos1, chunk);
+
+    /* If the table has to be calculated there is a % sign instead of a
+     * filename
+     */
+    std::string fn = getNextWord(line, pos1, pos2);
+    if (fn == "%") {
+        /* Get the number of points */
+        try {
+            npoints = std::stoi(getNextWord(line, pos1, pos2));
+        } catch (std::invalid_argument) {
+            throw xppParserException(EXPECTED_NUMBER, line, pos1);
+        }
+
+        /* Get the bounds */
+        parser.SetExpr(getNextWord(line, pos1, pos2));
+        try {
+            xLow = parser.Eval().GetFloat();
+        } catch (mup::ParserError) {
+            throw xppParserException(EXPECTED_NUMBER, line, pos1);
+        }
+        parser.SetExpr(getNextWord(line, pos1, pos2));
+        try {
+            xHigh = parser.Eval().GetFloat();
+        } catch (mup::ParserError) {
+            throw xppParserException(EXPECTED_NUMBER, line, pos1);
+        }
+
+        /* Parse the defining function */
+        const std::string expr = getNextWord(line, pos1, pos2);
+        double dx = (xHigh - xLow)/(npoints-1);
+
+        /* Evaluate the table expression in bulk if possible. Expressions it
+         * does not support or that yield no real number are left to muparserx
+         */
+        xppTableExpression bulk(expr);
+        if (!bulk.evaluate(xLow, dx, npoints, opt.Values, chunk.threads)) {
+            opt.Values.clear();
+            mup::Value t;
+            parser.DefineVar("t",  mup::Variable(&t));
+            parser.SetExpr(expr);
+            try {
+                opt.Values.reserve(npoints);
+                for(unsigned j = 0; j < npoints; j++) {
+                    t = (mup::float_type)(xLow + j * dx);
+                    opt.Values.push_back(parser.Eval().GetFloat());
                 }
+            } catch (mup::ParserError) {
+                throw xppParserException(WRONG_TABLE_ASSIGNMENT, line, pos1);
+            }
+        }
+    } else {
+        /* Map the file for parsing */
+        xppMappedFile file(fn);
+        if (!file.isOpen()) {
+            throw std::runtime_error("Cannot open table file " + fn + "\n");
+        }
 
-                /* Get the bounds */
-                parser.SetExpr(getNextWord(*line, pos1, pos2));
-                try {
-                    xLow = parser.Eval().GetFloat();
-                } catch (mup::ParserError) {
-                    throw xppParserException(EXPECTED_NUMBER, *line, pos1);
+        if (xppTableFile::isBinary(file.data(), file.size())) {
+            /* Binary tables are copied out of the mapping as a whole */
+            xppTable table;
+            if (!xppTableFile::readBinary(file.data(), file.size(), table)) {
+                throw std::runtime_error("Invalid binary table file " + fn + "\n");
+            }
+            xLow  = table.xLow;
+            xHigh = table.xHigh;
+            opt.Values.swap(table.values);
+        } else {
+            const char *pos = file.data();
+            const char *const end = pos + file.size();
+            lineNumber temp;
+            temp.second = 1;
+
+            /* Reads the next line of the table file. Plain numbers are
+             * converted directly, only expressions are passed to muparserx.
+             */
+            auto readValue = [&](double &value) {
+                if (pos >= end) {
+                    return false;
                 }
-                parser.SetExpr(getNextWord(*line, pos1, pos2));
-                try {
-                    xHigh = parser.Eval().GetFloat();
-                } catch (mup::ParserError) {
-                    throw xppParserException(EXPECTED_NUMBER, *line, pos1);
+                const char *eol = static_cast<const char*>(
+                            std::memchr(pos, '\n', end - pos));
+                if (eol == nullptr) {
+                    eol = end;
                 }
-
-                /* Parse the defining function */
-                mup::Value t;
-                parser.DefineVar("t",  mup::Variable(&t));
-                parser.SetExpr(getNextWord(*line, pos1, pos2));
-
-                /* Evaluate the table expression */
-                double dx = (xHigh - xLow)/(npoints-1);
-                try {
-                    opt.Args.reserve(npoints);
-                    for(unsigned j = 0; j < npoints; j++) {
-                        t = (mup::float_type)(xLow + j * dx);
-                        opt.Args.push_back(parser.Eval().ToString());
-                    }
-                } catch (mup::ParserError) {
-                    throw xppParserException(WRONG_TABLE_ASSIGNMENT, *line, pos1);
+                const char *first = pos;
+                const char *last = eol;
+                while (first < last && std::isspace(static_cast<unsigned char>(*first))) {
+                    ++first;
                 }
-            } else {
-                /* Open file for parsing */
-                std::ifstream fileStream(fn.c_str(), std::ios::in);
-                if (fileStream.fail()) {
-                    throw std::runtime_error("Cannot open table file " + fn + "\n");
+                while (last > first && std::isspace(static_cast<unsigned char>(last[-1]))) {
+                    --last;
                 }
-                lineNumber temp;
-                temp.second = 1;
-
-                /* Get the number of points */
-                try {
-                    getline(fileStream, temp.first);
-                    ++temp.second;
-                    npoints = std::stoi(temp.first);
-                } catch (std::invalid_argument) {
-                    throw xppParserException(EXPECTED_NUMBER, temp, pos1);
+                pos = eol < end ? eol + 1 : end;
+                ++temp.second;
+                temp.first = xppLineText(first, last - first);
+                if (!xppTableFile::parseNumber(first, last, value)) {
+                    parser.SetExpr(temp.first.str());
+                    value = parser.Eval().GetFloat();
                 }
+                return true;
+            };
 
-                /* Get the bounds */
-                getline(fileStream, temp.first);
-                ++temp.second;
-                parser.SetExpr(temp.first);
-                try {
-                    xLow = parser.Eval().GetFloat();
-                } catch (mup::ParserError) {
+            /* Get the number of points and the bounds. The number of points
+             * has to be a whole number that fits into npoints.
+             */
+            double points;
+            try {
+                if (!readValue(points) || !(points >= 0) ||
+                    points > std::numeric_limits<unsigned>::max() ||
+                    points != std::floor(points)) {
                     throw xppParserException(EXPECTED_NUMBER, temp, pos1);
                 }
-                getline(fileStream, temp.first);
-                ++temp.second;
-                parser.SetExpr(temp.first);
-                try {
-                    xHigh = parser.Eval().GetFloat();
-                } catch (mup::ParserError) {
+                npoints = static_cast<unsigned>(points);
+            } catch (mup::ParserError) {
+                throw xppParserException(EXPECTED_NUMBER, temp, pos1);
+            }
+            try {
+                if (!readValue(xLow) || !readValue(xHigh)) {
                     throw xppParserException(EXPECTED_NUMBER, temp, pos1);
                 }
+            } catch (mup::ParserError) {
+                throw xppParserException(EXPECTED_NUMBER, temp, pos1);
+            }
 
-                /* Parse the table values */
-                try {
-                    opt.Args.reserve(npoints);
-                    for(unsigned j = 0; j < npoints; j++) {
-                        if (getline(fileStream, temp.first)) {
-                            ++temp.second;
-                            parser.SetExpr(temp.first);
-                            opt.Args.push_back(parser.Eval().ToString());
-                        } else {
-                            throw xppParserException(EXPECTED_TABLE_ASSIGNMENT,
-                                                     temp, pos1);
-                        }
+            /* Parse the table values. Every value takes at least one character
+             * and a line break, so never reserve more than the rest of the file
+             * can hold.
+             */
+            try {
+                opt.Values.reserve(std::min<std::size_t>(npoints, (end - pos)/2 + 1));
+                for (unsigned j = 0; j < npoints; j++) {
+                    double value;
+                    if (!readValue(value)) {
+                        throw xppParserException(EXPECTED_TABLE_ASSIGNMENT,
+                                                 temp, pos1);
                     }
-                } catch (mup::ParserError) {
-                    throw xppParserException(WRONG_TABLE_ASSIGNMENT, temp, pos1);
+                    opt.Values.push_back(value);
                 }
-                fileStream.close();
+            } catch (mup::ParserError) {
+                throw xppParserException(WRONG_TABLE_ASSIGNMENT, temp, pos1);
             }
-            Tables.push_back(opt);
-            lines.erase(line);
-        } else {
-            ++line;
         }
+        chunk.tableFiles.push_back(fn);
     }
+
+    /* Store the bounds of the table with the shortest representation that
+     * reads back exactly
+     */
+    for (double bound : {xLow, xHigh}) {
+        std::ostringstream bounds;
+        bounds.precision(15);
+        bounds << bound;
+        if (std::strtod(bounds.str().c_str(), nullptr) != bound) {
+            bounds.str("");
+            bounds.precision(17);
+            bounds << bound;
+        }
+        opt.Args.push_back(bounds.str());
+    }
+    chunk.Tables.push_back(opt);
 }
 
 /**
  * @brief Extracts wiener processes
  *
+ * @par line: The line containing the wiener statement
+ * @par chunk: The chunk that contains the line
+ *
  * This function extracts the declaration of wiener processes as their
  * definition does not contain an equal sign but only the names of the
  * individual proceses.
  */
-void xppParser::extractWiener(void) {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("wiener");
-        std::size_t pos2 = line->first.find(" ", pos1);
-        if (pos1 != std::string::npos) {
-            while (pos2 != std::string::npos) {
-                Wieners.Args.push_back(getNextWord(*line, pos1, pos2));
-                checkName(Wieners.Args.back(), *line, pos1);
-            }
-            lines.erase(line);
-        } else {
-            ++line;
-        }
+void xppParser::extractWiener(const lineNumber &line, parsedChunk &chunk) {
+    std::size_t pos1 = 0, pos2 = 0;
+    getNextWord(line, pos1, pos2);
+    while (pos2 != std::string::npos) {
+        chunk.Wieners.Args.push_back(getNextWord(line, pos1, pos2));
+        checkName(chunk.Wieners.Args.back(), line, pos1, chunk);
     }
 }
 
 /**
  * @brief Extracts elements from a brace enclosed list
  *
- * @par line: String we are searching in
- * @par	closure: The bracket type { or (
+ * @par line: The line we are searching in
+ * @par first: Position of the opening bracket of the list
+ * @par last: Position after the end of the list
+ * @par	closure: The bracket type } or )
  * @par	delim: The delimiter type , or ;
  *
  * @return Args: Vector of strings of the list elements
  */
-stringList xppParser::getList(const std::string& line,
-                              unsigned ln,
-                              const std::string &closure,
-                              const std::string &delim) {
-    size_t pos1 = 1;
-    size_t pos2 = line.find_first_of(delim+closure, pos1);
+stringList xppParser::getList(const lineNumber &line, size_t first, size_t last,
+                              char closure, char delim) {
+    /* Commata and brackets are taken from the structural index */
+    auto nextDelimiter = [&](size_t pos) {
+        if (pos >= last) {
+            return std::string::npos;
+        }
+        size_t found = delim == ',' ? line.first.next(xppStructuralIndex::COMMA, pos)
+                                    : line.first.find(delim, pos);
+        size_t bracket = line.first.next(xppStructuralIndex::BRACKET, pos);
+        while (bracket < std::min(found, last) && line.first[bracket] != closure) {
+            bracket = line.first.next(xppStructuralIndex::BRACKET, bracket+1);
+        }
+        found = std::min(found, bracket);
+        return found < last ? found : std::string::npos;
+    };
+
+    size_t pos1 = first+1;
+    size_t pos2 = nextDelimiter(pos1);
     stringList temp;
     while (pos2 != std::string::npos) {
-        temp.push_back(line.substr(pos1, pos2-pos1));
+        temp.push_back(line.first.substr(pos1, pos2-pos1));
         if (temp.back().empty()) {
             throw xppParserException(EXPECTED_LIST_ARGUMENT,
-                                     std::make_pair(line, ln), pos1);
+                                     std::make_pair(line.first.substr(first, last-first),
+                                                    line.second),
+                                     pos1-first);
         }
         pos1 = pos2+1;
-        pos2 = line.find_first_of(delim+closure, pos1);
+        pos2 = nextDelimiter(pos1);
     }
     return temp;
 }
@@ -762,40 +1405,26 @@ std::string xppParser::getNextExpr(const lineNumber &line,
                                    size_t &pos1,
                                    size_t &pos2) {
     pos1 = pos2 + 1;
-    /* Search for the next commata outside of brackets */
-    std::stack<char> brackets;
-    auto it = line.first.begin();
-    for (std::advance(it, pos2); it != line.first.end(); ++it) {
-        switch (*it) {
-        case '(':
-            brackets.push(')');
-            break;
-        case '{':
-            brackets.push('}');
-            break;
-        case '[':
-            brackets.push(']');
-            break;
-        case ')':
-            brackets.pop();
-            break;
-        case '}':
-            brackets.pop();
-            break;
-        case ']':
-            brackets.pop();
-            break;
-        case ',':
-            if (brackets.empty()) {
-                pos2 = std::distance(line.first.begin(), it)+1;
-                it = std::prev(line.first.end());
-            } else {
-                continue;
+    /* Search for the next commata outside of brackets, jumping between the
+     * brackets and commata of the structural index
+     */
+    unsigned depth = 0;
+    size_t comma = line.first.next(xppStructuralIndex::COMMA, pos2);
+    size_t bracket = line.first.next(xppStructuralIndex::BRACKET, pos2);
+    while (comma != std::string::npos) {
+        if (bracket < comma) {
+            const char c = line.first[bracket];
+            if (c == '(' || c == '[' || c == '{') {
+                ++depth;
+            } else if (depth > 0) {
+                --depth;
             }
+            bracket = line.first.next(xppStructuralIndex::BRACKET, bracket+1);
+        } else if (depth == 0) {
+            pos2 = comma+1;
             break;
-        default:
-            continue;
-            break;
+        } else {
+            comma = line.first.next(xppStructuralIndex::COMMA, comma+1);
         }
     }
     /* If none was found copy the whole string */
@@ -803,10 +1432,17 @@ std::string xppParser::getNextExpr(const lineNumber &line,
         pos2 = std::string::npos;
     }
 
-    std::string expr = line.first.substr(pos1, pos2-pos1-1);
-
-    /* Remove whitespaces */
-    expr.erase(remove_if(expr.begin(), expr.end(), isspace), expr.end());
+    /* Copy the expression without whitespaces */
+    const size_t last = pos1 + std::min(pos2-pos1-1, line.first.size()-pos1);
+    std::string expr;
+    expr.reserve(last - std::min(pos1, last));
+    size_t word = pos1;
+    while (word < last) {
+        size_t space = line.first.next(xppStructuralIndex::WHITESPACE, word);
+        space = std::min(space, last);
+        expr.append(line.first.data() + word, space - word);
+        word = space + 1;
+    }
     return expr;
 }
 
@@ -824,25 +1460,72 @@ std::string xppParser::getNextExpr(const lineNumber &line,
 std::string xppParser::getNextWord(const lineNumber &line,
                                    size_t &pos1,
                                    size_t &pos2) {
-    pos1 = line.first.find_first_not_of(" ", pos2);
-    pos2 = line.first.find_first_of(" =", pos1);
+    /* Only blanks separate words, other whitespaces belong to them */
+    pos1 = pos2;
+    while (pos1 < line.first.size() &&
+           line.first.test(xppStructuralIndex::WHITESPACE, pos1) &&
+           line.first[pos1] == ' ') {
+        ++pos1;
+    }
+    if (pos1 >= line.first.size()) {
+        pos1 = std::string::npos;
+    }
+
+    size_t space = line.first.next(xppStructuralIndex::WHITESPACE, pos1);
+    while (space != std::string::npos && line.first[space] != ' ') {
+        space = line.first.next(xppStructuralIndex::WHITESPACE, space+1);
+    }
+    pos2 = std::min(space, line.first.next(xppStructuralIndex::EQUALS, pos1));
     return line.first.substr(pos1, pos2-pos1);
 }
 
 /**
- * @brief Initializes the keyword tree from the keyword list
+ * @brief Reports an error that occured while parsing
+ *
+ * @par exception: The exception that was thrown
+ * @par error: If not null, the message is stored there instead of being printed
+ *
+ * Unexpected errors are rethrown unless the message is stored.
  */
-void xppParser::initializeTries (void) {
-    keywords.addString(xppKeywords);
-
-    options.setCaseSensitivity(false);
-    options.setWholeWords(true);
-    options.addString(xppOptionNames);
-
-    reservedNames.setWholeWords(true);
-    reservedNames.addString(xppReservedNames);
+void xppParser::handleError(std::exception_ptr exception, std::string *error) {
+    auto report = [error](const char *msg) {
+        if (error) {
+            *error = msg;
+        } else {
+            std::cerr << msg;
+        }
+    };
+    try {
+        std::rethrow_exception(exception);
+    } catch (xppParserException& e) {
+        report(e.what());
+    } catch (std::runtime_error& e) {
+        report(e.what());
+    } catch (std::exception& e) {
+        report(e.what());
+    } catch (...) {
+        report("Unexpected error\n");
+        if (!error) {
+            throw;
+        }
+    }
+}
 
-    usedNames.setWholeWords(true);
+/**
+ * @brief Returns the trie of the xpp keywords
+ *
+ * The trie is created once and only read afterwards, so that it can be shared
+ * by all parsers, even on different threads. Reserved names and options are
+ * classified by the perfect hash tables in xppParserDefines.h instead.
+ */
+const keywordTrie::trie &xppParser::getKeywordTrie(void) {
+    static const keywordTrie::trie keywords = []() {
+        keywordTrie::trie trie;
+        trie.addString(stringList(std::begin(xppKeywords), std::end(xppKeywords)));
+        trie.compile();
+        return trie;
+    }();
+    return keywords;
 }
 
 /**
@@ -858,71 +1541,403 @@ bool xppParser::isNumeric(const std::string &str) {
     return (*p == 0.0);
 }
 
+/**
+ * @brief Parses a batch of ode files concurrently
+ *
+ * @par paths: The file names of the ode files
+ * @par config: The configuration used for every file, whose threads are the
+ * number of files that are parsed at the same time
+ *
+ * Every file is parsed by a single thread, while the keyword trie is
+ * shared between all of them. An error in one file is recorded in its result
+ * and does not stop the batch. If stats are recorded, the phases of all files
+ * are summed up in the summary.
+ *
+ * @return The outcome of every file together with the overall throughput
+ */
+xppParser::batchSummary xppParser::parseMany(const std::vector<std::string> &paths,
+                                             const xppParserConfig &config) {
+    typedef std::chrono::steady_clock clock;
+    batchSummary summary;
+    summary.results.resize(paths.size());
+
+    /* Create the shared state before the workers start */
+    getKeywordTrie();
+    mup::ParserX warmup;
+    mup::ParserErrorMsg::Instance();
+
+    /* The threads are spent on the files, so every file uses a single one */
+    xppParserConfig fileConfig = config;
+    fileConfig.threads = 1;
+
+    const unsigned threads = std::max(1u, std::min<unsigned>(config.threads, paths.size()));
+    std::vector<xppParserStats> threadStats(config.stats ? threads : 0);
+
+    const clock::time_point start = clock::now();
+    std::atomic<std::size_t> next(0);
+    auto worker = [&paths, &summary, &next, &fileConfig, &threadStats](unsigned thread) {
+        for (std::size_t i = next++; i < paths.size(); i = next++) {
+            batchResult &result = summary.results[i];
+            result.fileName = paths[i];
+            const clock::time_point fileStart = clock::now();
+            {
+                xppParser parser(paths[i], fileConfig, &result.error);
+                result.bytes = parser.fileSize;
+                if (fileConfig.stats) {
+                    threadStats[thread].merge(parser.stats);
+                }
+            }
+            result.seconds = std::chrono::duration<double>(clock::now() -
+                                                           fileStart).count();
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads-1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+    summary.seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    for (const xppParserStats &stats : threadStats) {
+        summary.stats.merge(stats);
+    }
+    summary.stats.totalSeconds = summary.seconds;
+
+    for (const batchResult &result : summary.results) {
+        summary.bytes += result.bytes;
+        if (!result.error.empty()) {
+            ++summary.failed;
+        }
+    }
+    return summary;
+}
+
+/**
+ * @brief Parses an ode file from a stream with bounded memory
+ *
+ * @par input: The stream the ode file is read from, e.g. std::cin
+ * @par sink: The function that receives every extracted definition
+ * @par config: The settings of the parser
+ * @par error: If not null, errors are stored there instead of being printed
+ *
+ * @return False if the ode file contains an error
+ *
+ * The stream is read in blocks of complete lines. Every block is processed
+ * as soon as it is read and its definitions are passed to the sink and then
+ * discarded, so that only the current block, an unfinished multi line
+ * statement and the trie of used names are kept in memory. The definitions
+ * of a block are passed to the sink grouped by their type, while the blocks
+ * themselves are passed in the order of the ode file.
+ */
+bool xppParser::parseStream(std::istream &input, const optsSink &sink,
+                            const xppParserConfig &config, std::string *error) {
+    static const std::size_t blockSize = 1 << 16;
+    try {
+        xppParser parser(config);
+        std::string buffer;
+        std::vector<char> block(blockSize);
+        unsigned lineCount = 1;
+        bool empty = true;
+        bool done = false;
+        while (!done) {
+            input.read(block.data(), block.size());
+            const std::size_t count = static_cast<std::size_t>(input.gcount());
+            buffer.append(block.data(), count);
+            parser.fileSize += count;
+
+            /* Only complete lines are read, unless the stream ended */
+            const bool eof = !input;
+            std::size_t end = buffer.size();
+            if (!eof) {
+                const std::size_t eol = buffer.rfind('\n');
+                end = eol == std::string::npos ? 0 : eol+1;
+            }
+            const xppStructuralIndex index(buffer.data(), end);
+            done = parser.readLines(buffer.data(), end, index, lineCount, false) || eof;
+            buffer.erase(0, end);
+
+            empty = empty && parser.lines.empty();
+            parser.streamLines(sink, done);
+        }
+        if (empty) {
+            throw std::runtime_error("Empty ode file " + parser.fileName + "\n");
+        }
+    } catch (...) {
+        handleError(std::current_exception(), error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Processes a single chunk
+ *
+ * @par chunk: The chunk that is processed
+ *
+ * Removes unnecessary whitespaces, expands the arrays and extracts the
+ * definitions of the chunk. Any error is stored within the chunk, so that it
+ * can be raised in the right order when the chunks are merged. Chunks that
+ * were already processed are skipped.
+ */
+void xppParser::processChunk(parsedChunk &chunk) {
+    if (chunk.processed) {
+        return;
+    }
+    chunk.processed = true;
+    xppParserStats *stats = chunk.stats;
+    try {
+        const std::size_t linesIn = chunk.lines.size();
+        xppParserStats::clock::time_point start = xppParserStats::start(stats);
+        removeWhitespace(chunk.lines);
+        if (stats) {
+            const double seconds = xppParserStats::elapsed(start);
+            stats->record(REMOVE_WHITESPACE, seconds, linesIn, chunk.lines.size(),
+                          xppParserStats::heapBytes(chunk.lines));
+            start = xppParserStats::clock::now();
+        }
+        expandArrays(chunk);
+        if (stats) {
+            const double seconds = xppParserStats::elapsed(start);
+            stats->record(EXPAND_ARRAYS, seconds, linesIn, chunk.lines.size(),
+                          xppParserStats::heapBytes(chunk.lines));
+        }
+    } catch (...) {
+        chunk.error = std::current_exception();
+        chunk.expansionFailed = true;
+        return;
+    }
+    try {
+        extractLines(chunk);
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+}
+
+/**
+ * @brief Processes all chunks on a number of threads
+ *
+ * @par chunks: The chunks that are processed
+ * @par threads: The number of threads
+ *
+ * The threads take the next unprocessed chunk until all chunks are done. The
+ * workers evaluate the tables of their chunks on their own thread, so that
+ * tables only use more threads if the chunks are processed serially.
+ */
+void xppParser::processChunks(std::vector<parsedChunk> &chunks, unsigned threads) {
+    const unsigned available = std::max(threads, 1u);
+    threads = std::min<std::size_t>(threads, chunks.size());
+    if (threads <= 1) {
+        /* A single chunk may use all threads for its tables */
+        for (parsedChunk &chunk : chunks) {
+            chunk.stats = config.stats ? &stats : nullptr;
+            chunk.threads = available;
+            processChunk(chunk);
+            chunk.stats = nullptr;
+            chunk.threads = 1;
+        }
+        return;
+    }
+
+    /* muparserx creates its packages and messages lazily and not thread safe,
+     * so make sure they exist before the workers start
+     */
+    mup::ParserX warmup;
+    mup::ParserErrorMsg::Instance();
+
+    /* Every thread records its own phases, which are summed up afterwards */
+    std::vector<xppParserStats> threadStats(config.stats ? threads : 0);
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [this, &chunks, &next, &threadStats](unsigned thread) {
+        for (std::size_t i = next++; i < chunks.size(); i = next++) {
+            chunks[i].stats = config.stats ? &threadStats[thread] : nullptr;
+            processChunk(chunks[i]);
+            chunks[i].stats = nullptr;
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads-1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+    for (const xppParserStats &local : threadStats) {
+        stats.merge(local);
+    }
+}
+
+/**
+ * @brief Maps the ode file and indexes its structural characters
+ *
+ * @par fn: Filename of the ode file
+ */
+xppParser::sourceFile::sourceFile(const std::string &fn)
+    : file(fn),
+      index(file.data(), file.size())
+{}
+
 /**
  * @brief Reads in the ode file and stores the lines in a vector
  *
  * This function reads in the ode file given by fileName, ignoring empty lines
- * as well lines containing only whitespace. Furthermore it trims and truncates
- * all whitespaces.
+ * as well lines containing only whitespace or a comment. Furthermore it trims
+ * and truncates all whitespaces, strips comments and checks the brackets.
+ *
+ * The file is memory mapped and the mapping is kept alive as source until all
+ * lines are processed. Lines that are used as they appear in the file are
+ * views into the mapping. Only lines whose runs of whitespaces are collapsed
+ * and those that are rewritten by later steps are copied, so that discarded
+ * and unmodified lines are never copied at all. This holds for incremental
+ * mode as well, as its statements do not keep their lines beyond the parse.
+ *
+ * All structural characters are located once by xppStructuralIndex, which is
+ * kept together with the mapping. readLines and the later steps jump between
+ * the set bits of its bitmaps instead of rescanning the bytes. Copied lines
+ * carry an index of their own.
  */
 void xppParser::readFile(void) {
-    std::ifstream fileStream(fileName.c_str(), std::ios::in);
-    if (fileStream.fail()) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    source = std::make_shared<const sourceFile>(fileName);
+    if (!source->file.isOpen()) {
         throw std::runtime_error("Cannot open ode file " + fileName + "\n");
     }
+    fileSize = source->file.size();
 
-    /* Parse in nonempty lines */
-    std::string line;
-    int lineCount = 1;
-    while (getline(fileStream, line)) {
-        size_t pos1 = line.find_first_not_of(" \t\f\v\r\n");
-        if (line == "done") {
-            break;
-        } else if (!line.empty() && pos1 != std::string::npos) {
-            /* Remove trailing and superflous whitespaces */
-            line.erase(0, pos1);
-            line.resize(line.find_last_not_of(" \t\f\v\r\n")+1);
-            auto last = std::unique(line.begin(), line.end(),
-                                    [](char l, char r){return std::isspace(l) &&
-                        std::isspace(r);});
-            line.erase(last, line.end());
-            lines.push_back(std::make_pair(line, lineCount));
-        }
-        ++lineCount;
-    }
+    unsigned lineCount = 1;
+    readLines(source->file.data(), source->file.size(), source->index, lineCount,
+              true);
 
     if (lines.empty()) {
         throw std::runtime_error("Empty ode file " + fileName + "\n");
     }
-    fileStream.close();
+    if (config.stats) {
+        const double seconds = xppParserStats::elapsed(start);
+        stats.record(READ_FILE, seconds, lineCount - 1, lines.size(),
+                     xppParserStats::heapBytes(lines));
+    }
 }
 
 /**
- * @brief Removes comments from ode files
+ * @brief Reads the nonempty lines of a buffer
+ *
+ * @par data: Pointer to the buffer
+ * @par size: Number of bytes in the buffer
+ * @par index: The structural index of the buffer
+ * @par lineCount: Number of the first line in the buffer. It is advanced past
+ * the last line that was read.
+ * @par views: Flag whether the lines may be views into the buffer, which then
+ * has to outlive them
  *
- * This function purges all standard comments from a ode file. If a line would
- * be comment only it is deleted.
+ * @return True if the end of the ode file was marked by "done"
+ *
+ * The lines are stripped of comments and superfluous whitespaces, their
+ * brackets are checked and they are appended to lines.
  */
-void xppParser::removeComments() {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1 = line->first.find("#");
-        if (pos1 == 0) {
-            lines.erase(line);
-        } else if (pos1 != std::string::npos) {
-            /* Check if this is the definition of a convolutional integral
-             * indicated by curly braces sourrunding the # sign
+bool xppParser::readLines(const char *data, std::size_t size,
+                          const xppStructuralIndex &index,
+                          unsigned &lineCount, bool views) {
+    /* Parse in nonempty lines */
+    std::vector<char> brackets;
+    std::size_t pos = 0;
+    while (pos < size) {
+        const std::size_t eol = index.next(xppStructuralIndex::NEWLINE, pos, size);
+        if (eol - pos == 4 && std::memcmp(data + pos, "done", 4) == 0) {
+            return true;
+        }
+
+        /* Remove leading whitespaces and comments. A # enclosed in curly
+         * braces marks a convolutional integral and is no comment.
+         */
+        std::size_t first = index.nextNot(xppStructuralIndex::WHITESPACE, pos, eol);
+        std::size_t last  = eol;
+        const std::size_t hash = index.next(xppStructuralIndex::COMMENT, first, eol);
+        if (hash != eol) {
+            std::size_t open = hash;
+            while (open > first && data[open-1] != '{') {
+                --open;
+            }
+            const void *close = open > first ?
+                        std::memchr(data + open, '}', eol - open) : nullptr;
+            if (open == first ||
+                (close != nullptr && static_cast<const char*>(close) < data + hash)) {
+                last = hash;
+            }
+        }
+
+        /* Remove trailing whitespaces */
+        while (last > first && index.test(xppStructuralIndex::WHITESPACE, last-1)) {
+            --last;
+        }
+
+        if (first != last) {
+            /* Search for a run of whitespaces. As the line is trimmed, every
+             * whitespace is followed by another character.
              */
-            std::size_t subpos1 = line->first.find_last_of("{", pos1);
-            std::size_t subpos2 = line->first.find("}", subpos1);
-            if (subpos1 == std::string::npos || subpos2 < pos1) {
-                line->first.resize(pos1);
+            std::size_t space = index.next(xppStructuralIndex::WHITESPACE, first, last);
+            while (space != last && !index.test(xppStructuralIndex::WHITESPACE, space+1)) {
+                space = index.next(xppStructuralIndex::WHITESPACE, space+2, last);
+            }
+
+            if (space == last) {
+                /* The line is used as it is */
+                if (views) {
+                    lines.push_back(std::make_pair(xppLineText(data + first, last - first,
+                                                               index, first),
+                                                   lineCount));
+                } else {
+                    lines.push_back(std::make_pair(std::string(data + first, last - first),
+                                                   lineCount));
+                }
+            } else {
+                /* Copy the line while collapsing superflous whitespaces */
+                std::string line;
+                line.reserve(last-first);
+                std::size_t word = first;
+                while (word < last) {
+                    space = index.next(xppStructuralIndex::WHITESPACE, word, last);
+                    line.append(data + word, space - word);
+                    if (space == last) {
+                        break;
+                    }
+                    line.push_back(data[space]);
+                    word = index.nextNot(xppStructuralIndex::WHITESPACE, space, last);
+                }
+                lines.push_back(std::make_pair(std::move(line), lineCount));
+            }
+
+            /* Check the brackets of the line. Only in case of an error the
+             * line is checked again to determine the position of the error.
+             */
+            brackets.clear();
+            std::size_t bracket = index.next(xppStructuralIndex::BRACKET, first, last);
+            while (bracket != last) {
+                const char c = data[bracket];
+                if (c == '(' || c == '[' || c == '{') {
+                    brackets.push_back(c);
+                } else if (brackets.empty() ||
+                           brackets.back() != (c == ')' ? '(' : c == ']' ? '[' : '{')) {
+                    checkBrackets(lines.back());
+                } else {
+                    brackets.pop_back();
+                }
+                bracket = index.next(xppStructuralIndex::BRACKET, bracket+1, last);
+            }
+            if (!brackets.empty()) {
+                checkBrackets(lines.back());
             }
-            ++line;
-        } else {
-            ++line;
         }
+        pos = eol + 1;
+        ++lineCount;
     }
+    return false;
 }
 
 /**
@@ -930,42 +1945,96 @@ void xppParser::removeComments() {
  *
  * This function searches for whitespaces within parentheses or before/after an
  * equal sign and removes those.
+ *
+ * The positions are found through the structural index of the line, so that
+ * only lines that actually change are copied.
+ *
+ * @par lines: The lines of a chunk
  */
-void xppParser::removeWhitespace() {
-    auto line = lines.begin();
-    while (line != lines.end()) {
-        std::size_t pos1, pos2, pos3;
-
-        /* Remove all whitespaces between brackets */
-        pos1 = line->first.find("(");
-        if (pos1 != std::string::npos) {
-            pos2 = line->first.find(")");
-            pos3 = line->first.find_first_of(" \t\f\v\r", pos1);
-            while (pos3 < pos2) {
-                line->first.erase(pos3, 1);
-                pos3 = line->first.find_first_of(" \t\f\v\r", pos1);
+void xppParser::removeWhitespace(std::vector<lineNumber> &lines) {
+    static const std::size_t npos = std::string::npos;
+    for (lineNumber &line : lines) {
+        const xppLineText &text = line.first;
+        const std::size_t size = text.size();
+
+        /* Remove the whitespaces after the first opening bracket as long as
+         * they precede the position the first closing bracket had before
+         * anything was removed.
+         */
+        std::size_t bracketFirst = size, bracketLast = size;
+        std::size_t open = text.next(xppStructuralIndex::BRACKET, 0);
+        while (open != npos && text[open] != '(') {
+            open = text.next(xppStructuralIndex::BRACKET, open+1);
+        }
+        if (open != npos) {
+            std::size_t close = text.next(xppStructuralIndex::BRACKET, 0);
+            while (close != npos && text[close] != ')') {
+                close = text.next(xppStructuralIndex::BRACKET, close+1);
             }
+            std::size_t removed = 0;
+            std::size_t space = text.next(xppStructuralIndex::WHITESPACE, open);
+            while (space != npos && space - removed < close) {
+                ++removed;
+                space = text.next(xppStructuralIndex::WHITESPACE, space+1);
+            }
+            bracketFirst = open;
+            bracketLast  = space == npos ? size : space;
         }
 
-        /* Search around the equal signs */
-        pos1 = line->first.find("=");
-        if (pos1 != std::string::npos) {
-            pos2 = line->first.find_first_not_of(" \t\f\v\r", pos1+1);
-            if (pos2 != pos1+1) {
-                line->first.erase(pos1+1, pos2-pos1-1);
+        /* Search around the first equal sign. If it starts the line, trailing
+         * whitespaces are removed instead of leading ones.
+         */
+        std::size_t equalsFirst = size, equalsLast = size, trailing = size;
+        const std::size_t equals = text.next(xppStructuralIndex::EQUALS, 0);
+        if (equals != npos) {
+            equalsLast = text.nextNot(xppStructuralIndex::WHITESPACE, equals+1);
+            if (equalsLast == npos) {
+                equalsLast = size;
             }
-            pos2 = line->first.find_last_not_of(" \t\f\v\r", pos1-1);
-            if (pos2 != pos1-1) {
-                line->first.erase(pos2+1, pos1-pos2-1);
+            equalsFirst = equals;
+            if (equals == 0) {
+                while (trailing > 0 && text.test(xppStructuralIndex::WHITESPACE, trailing-1)) {
+                    --trailing;
+                }
+            } else {
+                while (equalsFirst > 0 &&
+                       text.test(xppStructuralIndex::WHITESPACE, equalsFirst-1)) {
+                    --equalsFirst;
+                }
+            }
+        }
+
+        /* Copy the line only if a whitespace is removed */
+        std::string result;
+        bool changed = false;
+        std::size_t copied = 0;
+        std::size_t space = text.next(xppStructuralIndex::WHITESPACE, 0);
+        while (space != npos) {
+            if ((space >= bracketFirst && space < bracketLast) ||
+                (space >= equalsFirst && space < equalsLast) ||
+                space >= trailing) {
+                result.append(text.data() + copied, space - copied);
+                copied = space + 1;
+                changed = true;
             }
+            space = text.next(xppStructuralIndex::WHITESPACE, space+1);
         }
 
         /* Remove trailing commata etc */
-        pos1 = line->first.find_last_not_of(",;");
-        if (pos1 != line->first.size()-1) {
-            line->first.resize(pos1+1);
+        if (changed) {
+            result.append(text.data() + copied, size - copied);
+        }
+        const char *data = changed ? result.data() : text.data();
+        std::size_t last = changed ? result.size() : size;
+        while (last > 0 && (data[last-1] == ',' || data[last-1] == ';')) {
+            --last;
+        }
+        if (changed) {
+            result.resize(last);
+            line.first.assign(std::move(result));
+        } else if (last != size) {
+            line.first.assign(text.substr(0, last));
         }
-        ++line;
     }
 }
 
@@ -973,7 +2042,8 @@ void xppParser::removeWhitespace() {
  * @brief Performs a keyword search and cleanes up multiple results
  *
  * @par expr: The std::string to be searched for the keyword
- * @par character: The character after expr.
+ * @par line: The line that contains expr
+ * @par pos: The position of the character after expr within line
  *
  * This sanitizes the keyword search in case we have multiple matches. If
  * multiple keywords were found, the name of the expression contains a keyword.
@@ -982,12 +2052,14 @@ void xppParser::removeWhitespace() {
  * there were no valid keywords left/found this must be a temporary expression.
  * So create a fake result with and index equal to the size of xppKeywords.
  */
-keywordTrie::result xppParser::keywordSearch(const std::string &expr,
-                                             const char &character) {
-    keywordTrie::resultCollection results = keywords.parseText(expr);
-    if(character == '=') {
+keywordTrie::match xppParser::keywordSearch(const std::string &expr,
+                                            const xppLineText &line,
+                                            size_t pos) {
+    keywordTrie::matchCollection results;
+    keywords.parseText(expr, results);
+    if(line.test(xppStructuralIndex::EQUALS, pos)) {
         auto it = results.begin();
-        for (keywordTrie::result &res : results) {
+        for (keywordTrie::match &res : results) {
             if (res.id == 0 || /* !Name */
                 res.id == 2 || /* Name' */
                 res.id == 3 || /* dName/dt */
@@ -1003,12 +2075,866 @@ keywordTrie::result xppParser::keywordSearch(const std::string &expr,
         }
         /* No valid keyword left, this must be an expression */
         if (results.empty()) {
-            results.push_back(keywordTrie::result("", xppKeywords.size()));
+            results.push_back(keywordTrie::match{std::extent<decltype(xppKeywords)>::value, 0, 0});
         }
     }
     return results.front();
 }
 
+/**
+ * @brief Loads the parsed model from the cache
+ *
+ * The key of the image is the hash of the ode file contents, which is kept so
+ * that storeCache does not have to hash the file again.
+ *
+ * @return False if there is no valid image of the ode file
+ */
+bool xppParser::loadCache(void) {
+    xppMappedFile file(fileName);
+    if (!file.isOpen()) {
+        return false;
+    }
+    cacheKey = xppModelCache::contentHash(file.data(), file.size());
+
+    xppModelCache::model cached;
+    if (!xppModelCache(config.cacheDirectory, config.symbolicArrays).load(cacheKey, file.size(), cached)) {
+        return false;
+    }
+    static_cast<optsCollection&>(*this) = std::move(cached.opts);
+    tableFiles.swap(cached.tableFiles);
+    usedNames.reserve(cached.names.size());
+    for (const std::string &name : cached.names) {
+        usedNames.insert(name);
+    }
+    resolveSymbols(*this);
+    fileSize = file.size();
+    return true;
+}
+
+/**
+ * @brief Returns the functions of a library and the files it depends on
+ *
+ * @par fn: The file name of the library
+ *
+ * Libraries are parsed once per process and kept as long as neither their
+ * contents nor those of their table files and nested libraries change. With a
+ * cache directory the parsed library is stored as an image as well, so later
+ * runs load it without parsing. A library must not contain anything but
+ * functions.
+ */
+std::shared_ptr<const xppParser::parsedLibrary> xppParser::loadLibrary(const std::string &fn) {
+    struct library {
+        uint64_t								key;
+        std::size_t								size;
+        std::vector<uint64_t>					hashes;
+        std::shared_ptr<const parsedLibrary>	content;
+    };
+
+    /* Hashes the contents of a file the library depends on */
+    auto fileHash = [](const std::string &name, uint64_t &hash) {
+        xppMappedFile file(name);
+        if (!file.isOpen()) {
+            return false;
+        }
+        hash = xppModelCache::contentHash(file.data(), file.size());
+        return true;
+    };
+    static std::mutex mutex;
+    static std::unordered_map<std::string, library> libraries;
+
+    /* Libraries that are currently parsed by this thread */
+    static thread_local stringList loading;
+
+    std::size_t size;
+    uint64_t key;
+    {
+        xppMappedFile file(fn);
+        if (!file.isOpen()) {
+            throw std::runtime_error("Cannot open library " + fn + "\n");
+        }
+        size = file.size();
+        key = xppModelCache::contentHash(file.data(), file.size());
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto known = libraries.find(fn);
+        if (known != libraries.end() && known->second.key == key &&
+            known->second.size == size) {
+            const library &cached = known->second;
+            bool unchanged = true;
+            for (std::size_t i = 0; unchanged && i < cached.hashes.size(); ++i) {
+                uint64_t hash;
+                unchanged = fileHash(cached.content->tableFiles[i], hash) &&
+                            hash == cached.hashes[i];
+            }
+            if (unchanged) {
+                return cached.content;
+            }
+        }
+    }
+    if (std::find(loading.begin(), loading.end(), fn) != loading.end()) {
+        throw std::runtime_error("Library " + fn + " includes itself\n");
+    }
+
+    xppParserConfig libraryConfig;
+    libraryConfig.cacheDirectory = config.cacheDirectory;
+    std::string error;
+    loading.push_back(fn);
+    xppParser parser(fn, libraryConfig, &error);
+    loading.pop_back();
+    if (!error.empty()) {
+        throw std::runtime_error("Error in library " + fn + ":\n" + error);
+    }
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        if (array != &optsCollection::Functions && !(parser.*array).empty()) {
+            throw std::runtime_error("Library " + fn + " may only contain functions\n");
+        }
+    }
+    if (!parser.Wieners.Args.empty()) {
+        throw std::runtime_error("Library " + fn + " may only contain functions\n");
+    }
+
+    std::shared_ptr<parsedLibrary> content = std::make_shared<parsedLibrary>();
+    content->functions.swap(parser.Functions);
+    content->tableFiles.swap(parser.tableFiles);
+    std::vector<uint64_t> hashes(content->tableFiles.size());
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        if (!fileHash(content->tableFiles[i], hashes[i])) {
+            throw std::runtime_error("Cannot open file " + content->tableFiles[i] +
+                                     " of library " + fn + "\n");
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    libraries[fn] = library{key, size, std::move(hashes), content};
+    return content;
+}
+
+/**
+ * @brief Registers the names and collects the opts arrays of all chunks
+ *
+ * @par chunks: The processed chunks in the order of the ode file
+ * @par merged: If not null, every chunk is a single statement, whose ranges in
+ * the model are recorded there
+ *
+ * The chunks are merged in their original order. The names of each chunk are
+ * registered before its opts arrays are appended, so that duplicated or unknown
+ * names are found exactly as if the whole file was processed at once. Errors
+ * that occured during the processing of a chunk are rethrown at the point the
+ * serial parser would have encountered them.
+ */
+void xppParser::mergeChunks(std::vector<parsedChunk> &chunks,
+                            std::vector<statement> *merged) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    const optsCollection::arrayList &arrays = optsCollection::arrays();
+    std::size_t definitions = 0;
+
+    /* Array expansion precedes the extraction of all definitions */
+    for (parsedChunk &chunk : chunks) {
+        if (chunk.expansionFailed) {
+            std::rethrow_exception(chunk.error);
+        }
+    }
+
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        parsedChunk &chunk = chunks[i];
+        const std::size_t declared = usedNames.size();
+        for (const pendingName &name : chunk.names) {
+            if (name.range == nullptr) {
+                declareName(name.name, name);
+                if (merged && !name.declare) {
+                    (*merged)[i].references.push_back(name.name);
+                }
+                continue;
+            }
+
+            /* Check the name of every member of a symbolic array family */
+            for (const std::string &member :
+                 expandIndices(name.name, *name.line, name.range->Start,
+                               name.range->End)) {
+                declareName(member, name);
+                if (merged && !name.declare) {
+                    (*merged)[i].references.push_back(member);
+                }
+            }
+        }
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+        resolveSymbols(chunk);
+        if (config.stats) {
+            definitions += xppParserStats::definitionCount(chunk);
+        }
+        if (merged) {
+            statement &current = (*merged)[i];
+            for (std::size_t type = 0; type < arrays.size(); ++type) {
+                current.definitions[type] = (chunk.*arrays[type]).size();
+            }
+            current.wieners	   = chunk.Wieners.Args.size();
+            current.tableFiles = chunk.tableFiles.size();
+            current.names	   = usedNames.size() - declared;
+        }
+        for (optsArray optsCollection::*array : arrays) {
+            optsArray &target = this->*array;
+            optsArray &source = chunk.*array;
+            if (target.empty()) {
+                target.swap(source);
+            } else {
+                target.insert(target.end(),
+                              std::make_move_iterator(source.begin()),
+                              std::make_move_iterator(source.end()));
+            }
+        }
+        tableFiles.insert(tableFiles.end(),
+                          std::make_move_iterator(chunk.tableFiles.begin()),
+                          std::make_move_iterator(chunk.tableFiles.end()));
+        Wieners.Args.insert(Wieners.Args.end(),
+                            std::make_move_iterator(chunk.Wieners.Args.begin()),
+                            std::make_move_iterator(chunk.Wieners.Args.end()));
+    }
+    if (config.stats) {
+        const double seconds = xppParserStats::elapsed(start);
+        stats.record(MERGE_CHUNKS, seconds, definitions,
+                     xppParserStats::definitionCount(*this),
+                     xppParserStats::heapBytes(*this));
+    }
+}
+
+/**
+ * @brief Splices the changed statements into the model of the last parse
+ *
+ * @par current: The statements of the edited ode file, whose ranges are filled
+ * @par reusedFrom: For every statement the index of the unchanged statement
+ * of the last parse it corresponds to, or none if it changed
+ * @par changed: The processed chunks of the changed statements in order
+ *
+ * @return False if the changes cannot be spliced into the model
+ *
+ * The definitions of unchanged statements are kept in the model and only their
+ * line numbers are adjusted. If every changed statement replaces a statement at
+ * the same position with as many definitions and the same names, the new
+ * definitions are moved into the ranges of the old ones and the used names
+ * stay as they are. Otherwise the model is rebuilt by moving the ranges of the
+ * unchanged statements and the definitions of the changed ones into new
+ * arrays in the order of the file, and the used names are registered again.
+ *
+ * Nothing is modified unless the splice succeeds. It fails if a changed
+ * statement contains an error or a name is duplicated or unknown, as well as if
+ * the model no longer matches the ranges of the last parse. The caller then
+ * parses all statements, so that errors are reported exactly as by a fresh
+ * parse.
+ */
+bool xppParser::spliceStatements(std::vector<statement> &current,
+                                 const std::vector<std::size_t> &reusedFrom,
+                                 std::vector<parsedChunk> &changed) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    const optsCollection::arrayList &arrays = optsCollection::arrays();
+    const std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    /* Positions of the ranges of a statement in the model */
+    struct position {
+        std::array<std::size_t, std::tuple_size<optsCollection::arrayList>::value> definitions{};
+        std::size_t	wieners		= 0;
+        std::size_t	tableFiles	= 0;
+        std::size_t	names		= 0;
+    };
+    std::vector<position> previous(statements.size() + 1);
+    for (std::size_t j = 0; j < statements.size(); ++j) {
+        for (std::size_t type = 0; type < arrays.size(); ++type) {
+            previous[j+1].definitions[type] = previous[j].definitions[type] +
+                                              statements[j].definitions[type];
+        }
+        previous[j+1].wieners	 = previous[j].wieners + statements[j].wieners;
+        previous[j+1].tableFiles = previous[j].tableFiles + statements[j].tableFiles;
+        previous[j+1].names		 = previous[j].names + statements[j].names;
+    }
+    const position &total = previous.back();
+    for (std::size_t type = 0; type < arrays.size(); ++type) {
+        if (total.definitions[type] != (this->*arrays[type]).size()) {
+            return false;
+        }
+    }
+    if (total.wieners != Wieners.Args.size() || total.tableFiles != tableFiles.size() ||
+        total.names != usedNames.size()) {
+        return false;
+    }
+
+    /* Collect the names of the changed statements. A statement that declares
+     * names and refers to others is left to the full parse, which checks them
+     * in their original order.
+     */
+    std::vector<stringList> declared(changed.size()), references(changed.size());
+    std::size_t definitions = 0;
+    for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+        if (reusedFrom[i] != none) {
+            continue;
+        }
+        const parsedChunk &chunk = changed[k];
+        if (chunk.error) {
+            return false;
+        }
+        for (const pendingName &name : chunk.names) {
+            const stringList members = name.range == nullptr ?
+                        stringList(1, name.name) :
+                        expandIndices(name.name, *name.line, name.range->Start,
+                                      name.range->End);
+            for (const std::string &member : members) {
+                if (!name.declare) {
+                    references[k].push_back(member);
+                } else if (!member.empty()) {
+                    declared[k].push_back(member);
+                }
+            }
+        }
+        if (!declared[k].empty() && !references[k].empty()) {
+            return false;
+        }
+        for (std::size_t type = 0; type < arrays.size(); ++type) {
+            current[i].definitions[type] = (chunk.*arrays[type]).size();
+            definitions += current[i].definitions[type];
+        }
+        current[i].wieners	  = chunk.Wieners.Args.size();
+        current[i].tableFiles = chunk.tableFiles.size();
+        current[i].names	  = declared[k].size();
+        ++k;
+    }
+
+    /* Check whether every changed statement fits into the ranges of the
+     * statement it replaces
+     */
+    bool inPlace = current.size() == statements.size();
+    for (std::size_t i = 0, k = 0; inPlace && i < current.size(); ++i) {
+        if (reusedFrom[i] != none) {
+            inPlace = reusedFrom[i] == i;
+            continue;
+        }
+        const statement &old = statements[i];
+        inPlace = old.definitions == current[i].definitions &&
+                  old.wieners == current[i].wieners &&
+                  old.tableFiles == current[i].tableFiles &&
+                  old.names == current[i].names;
+        for (std::size_t n = 0; inPlace && n < declared[k].size(); ++n) {
+            inPlace = usedNames.name(previous[i].names + n) == declared[k][n];
+        }
+        for (const std::string &reference : references[k]) {
+            const unsigned symbol = usedNames.find(reference);
+            inPlace = inPlace && symbol != noSymbol && symbol < previous[i].names;
+        }
+        ++k;
+    }
+
+    /* Otherwise register all names again in the order of the file */
+    xppSymbolTable names;
+    std::vector<std::size_t> namesEnd(current.size());
+    if (!inPlace) {
+        names.reserve(total.names);
+        for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+            const std::size_t j = reusedFrom[i];
+            const stringList &required = j != none ? statements[j].references
+                                                   : references[k];
+            for (const std::string &reference : required) {
+                if (!names.contains(reference)) {
+                    return false;
+                }
+            }
+            if (j != none) {
+                for (std::size_t n = 0; n < statements[j].names; ++n) {
+                    if (!names.insert(usedNames.name(previous[j].names + n)).second) {
+                        return false;
+                    }
+                }
+            } else {
+                for (const std::string &name : declared[k++]) {
+                    if (!names.insert(name).second) {
+                        return false;
+                    }
+                }
+            }
+            namesEnd[i] = names.size();
+        }
+    }
+
+    /* A definition refers to the names declared up to its own statement */
+    auto resolve = [](optsArray::iterator first, optsArray::iterator last,
+                      const xppSymbolTable &table, std::size_t declared) {
+        for (; first != last; ++first) {
+            const unsigned symbol = table.find(first->Name);
+            first->Symbol = symbol < declared ? symbol : noSymbol;
+        }
+    };
+    auto shift = [](optsArray::iterator first, optsArray::iterator last,
+                    int offset) {
+        for (; offset != 0 && first != last; ++first) {
+            first->Line += offset;
+            if (first->Range.Line != 0) {
+                first->Range.Line += offset;
+            }
+        }
+    };
+
+    if (inPlace) {
+        /* Move the definitions into the ranges of the old ones */
+        for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+            const position &first = previous[i];
+            if (reusedFrom[i] != none) {
+                const int offset = int(current[i].firstLine) - int(statements[i].firstLine);
+                for (std::size_t type = 0; type < arrays.size(); ++type) {
+                    optsArray &target = this->*arrays[type];
+                    shift(target.begin() + first.definitions[type],
+                          target.begin() + previous[i+1].definitions[type], offset);
+                }
+                continue;
+            }
+            parsedChunk &chunk = changed[k];
+            for (std::size_t type = 0; type < arrays.size(); ++type) {
+                optsArray &target = this->*arrays[type];
+                optsArray &source = chunk.*arrays[type];
+                const optsArray::iterator begin = target.begin() + first.definitions[type];
+                std::move(source.begin(), source.end(), begin);
+                resolve(begin, begin + source.size(), usedNames, previous[i+1].names);
+            }
+            std::move(chunk.Wieners.Args.begin(), chunk.Wieners.Args.end(),
+                      Wieners.Args.begin() + first.wieners);
+            std::move(chunk.tableFiles.begin(), chunk.tableFiles.end(),
+                      tableFiles.begin() + first.tableFiles);
+            ++k;
+        }
+    } else {
+        /* Collect the ranges of the unchanged statements and the definitions
+         * of the changed ones in the order of the file
+         */
+        for (std::size_t type = 0; type < arrays.size(); ++type) {
+            optsArray &target = this->*arrays[type];
+            std::size_t size = 0;
+            for (std::size_t i = 0; i < current.size(); ++i) {
+                size += reusedFrom[i] != none ? statements[reusedFrom[i]].definitions[type]
+                                              : current[i].definitions[type];
+            }
+            optsArray merged;
+            merged.reserve(size);
+            for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+                const std::size_t j = reusedFrom[i];
+                const std::size_t begin = merged.size();
+                if (j != none) {
+                    merged.insert(merged.end(),
+                                  std::make_move_iterator(target.begin() + previous[j].definitions[type]),
+                                  std::make_move_iterator(target.begin() + previous[j+1].definitions[type]));
+                    shift(merged.begin() + begin, merged.end(),
+                          int(current[i].firstLine) - int(statements[j].firstLine));
+                } else {
+                    optsArray &source = changed[k++].*arrays[type];
+                    merged.insert(merged.end(), std::make_move_iterator(source.begin()),
+                                  std::make_move_iterator(source.end()));
+                }
+                resolve(merged.begin() + begin, merged.end(), names, namesEnd[i]);
+            }
+            target.swap(merged);
+        }
+        stringList wieners, files;
+        for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+            const std::size_t j = reusedFrom[i];
+            if (j != none) {
+                wieners.insert(wieners.end(),
+                               std::make_move_iterator(Wieners.Args.begin() + previous[j].wieners),
+                               std::make_move_iterator(Wieners.Args.begin() + previous[j+1].wieners));
+                files.insert(files.end(),
+                             std::make_move_iterator(tableFiles.begin() + previous[j].tableFiles),
+                             std::make_move_iterator(tableFiles.begin() + previous[j+1].tableFiles));
+            } else {
+                parsedChunk &chunk = changed[k++];
+                wieners.insert(wieners.end(),
+                               std::make_move_iterator(chunk.Wieners.Args.begin()),
+                               std::make_move_iterator(chunk.Wieners.Args.end()));
+                files.insert(files.end(),
+                             std::make_move_iterator(chunk.tableFiles.begin()),
+                             std::make_move_iterator(chunk.tableFiles.end()));
+            }
+        }
+        Wieners.Args.swap(wieners);
+        tableFiles.swap(files);
+        usedNames = std::move(names);
+    }
+
+    /* Record the ranges of the statements for the next update */
+    for (std::size_t i = 0, k = 0; i < current.size(); ++i) {
+        const std::size_t j = reusedFrom[i];
+        if (j != none) {
+            current[i].definitions = statements[j].definitions;
+            current[i].wieners	   = statements[j].wieners;
+            current[i].tableFiles  = statements[j].tableFiles;
+            current[i].names	   = statements[j].names;
+            current[i].references.swap(statements[j].references);
+        } else {
+            current[i].references.swap(references[k++]);
+        }
+    }
+    statements.swap(current);
+
+    if (config.stats) {
+        const double seconds = xppParserStats::elapsed(start);
+        stats.record(MERGE_CHUNKS, seconds, definitions,
+                     xppParserStats::definitionCount(*this),
+                     xppParserStats::heapBytes(*this));
+    }
+    return true;
+}
+
+/**
+ * @brief Splits the lines into single statements
+ *
+ * @par bounds: Filled with the index of the first line of every statement in
+ * lines, followed by the number of lines
+ *
+ * @return The statements, which are identified by the hash of their lines
+ *
+ * Tables that are read from a file and libraries depend on more than their
+ * line and are therefore never reused.
+ */
+std::vector<xppParser::statement> xppParser::splitStatements(std::vector<std::size_t> &bounds) {
+    std::vector<statement> found;
+    bounds.clear();
+    auto line = lines.cbegin();
+    while (line != lines.cend()) {
+        const auto last = endOfBlock(line, lines.cend());
+        bounds.push_back(std::distance(lines.cbegin(), line));
+        found.push_back(statement());
+        statement &current = found.back();
+        current.firstLine = line->second;
+        current.hash = xppHashSeed;
+        for (auto it = line; it != last; ++it) {
+            /* Include a terminating zero just like xppHash of a std::string */
+            current.hash = xppHash(it->first.data(), it->first.size(), current.hash);
+            current.hash = xppHash("", 1, current.hash);
+        }
+        if (line->first.compare(0, 6, "table ") == 0) {
+            std::size_t pos1 = 0, pos2 = 0;
+            getNextWord(*line, pos1, pos2);
+            getNextWord(*line, pos1, pos2);
+            current.reusable = pos2 != std::string::npos &&
+                               getNextWord(*line, pos1, pos2) == "%";
+        } else if (line->first.compare(0, 8, "library ") == 0) {
+            current.reusable = false;
+        }
+        line = last;
+    }
+    bounds.push_back(lines.size());
+    return found;
+}
+
+/**
+ * @brief Moves the lines of single statements into chunks of their own
+ *
+ * @par bounds: The first line of every statement, see splitStatements
+ * @par selected: Flags for every statement whether it gets a chunk
+ *
+ * The lines stay views into the mapped ode file, which is kept alive as source
+ * until the chunks are merged.
+ */
+std::vector<xppParser::parsedChunk> xppParser::splitBlocks(const std::vector<std::size_t> &bounds,
+                                                          const std::vector<bool> &selected) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    std::size_t linesIn = 0;
+    std::vector<parsedChunk> chunks;
+    for (std::size_t i = 0; i < selected.size(); ++i) {
+        if (!selected[i]) {
+            continue;
+        }
+        chunks.push_back(parsedChunk());
+        chunks.back().lines.assign(std::make_move_iterator(lines.begin() + bounds[i]),
+                                   std::make_move_iterator(lines.begin() + bounds[i+1]));
+        linesIn += bounds[i+1] - bounds[i];
+    }
+    recordSplit(start, linesIn, chunks);
+    return chunks;
+}
+
+/**
+ * @brief Splits the lines into chunks of complete statements
+ *
+ * @par numChunks: The desired number of chunks
+ *
+ * The lines are moved into roughly equally sized chunks, which share the
+ * mapped ode file the lines are views into. A chunk only ends after a complete
+ * statement, so that multi line statements are never split. Very small files
+ * are not split at all.
+ */
+std::vector<xppParser::parsedChunk> xppParser::splitChunks(unsigned numChunks) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    const std::size_t linesIn = lines.size();
+    const std::size_t minChunkSize = 1024;
+    const std::size_t chunkSize = std::max(minChunkSize,
+                                           (lines.size() + numChunks - 1) /
+                                           std::max(numChunks, 1u));
+
+    std::vector<parsedChunk> chunks;
+    if (lines.size() <= chunkSize) {
+        chunks.push_back(parsedChunk());
+        chunks.back().lines.swap(lines);
+        chunks.back().source.swap(source);
+        recordSplit(start, linesIn, chunks);
+        return chunks;
+    }
+
+    auto first = lines.cbegin();
+    auto line = first;
+    while (line != lines.cend()) {
+        line = endOfBlock(line, lines.cend());
+        if (std::distance(first, line) >= std::ptrdiff_t(chunkSize) ||
+            line == lines.cend()) {
+            chunks.push_back(parsedChunk());
+            chunks.back().lines.assign(
+                        std::make_move_iterator(lines.begin() + std::distance(lines.cbegin(), first)),
+                        std::make_move_iterator(lines.begin() + std::distance(lines.cbegin(), line)));
+            chunks.back().source = source;
+            first = line;
+        }
+    }
+    lines.clear();
+    source.reset();
+    recordSplit(start, linesIn, chunks);
+    return chunks;
+}
+
+/**
+ * @brief Records the split of the lines into chunks
+ *
+ * @par start: The start of the split
+ * @par linesIn: The number of lines before the split
+ * @par chunks: The resulting chunks
+ */
+void xppParser::recordSplit(xppParserStats::clock::time_point start,
+                            std::size_t linesIn,
+                            const std::vector<parsedChunk> &chunks) {
+    if (!config.stats) {
+        return;
+    }
+    const double seconds = xppParserStats::elapsed(start);
+    std::size_t linesOut = 0, bytes = chunks.capacity()*sizeof(parsedChunk);
+    for (const parsedChunk &chunk : chunks) {
+        linesOut += chunk.lines.size();
+        bytes += xppParserStats::heapBytes(chunk.lines);
+    }
+    stats.record(SPLIT_CHUNKS, seconds, linesIn, linesOut, bytes);
+}
+
+/**
+ * @brief Stores the parsed model in the cache
+ *
+ * Failing to write the image is not an error, the file is simply parsed again
+ * on the next run.
+ */
+void xppParser::storeCache(void) {
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+    xppModelCache::model model;
+    model.opts = *this;
+    model.names = usedNames.names();
+    model.tableFiles = tableFiles;
+    xppModelCache(config.cacheDirectory, config.symbolicArrays).store(cacheKey, fileSize, model);
+    if (config.stats) {
+        const double seconds = xppParserStats::elapsed(start);
+        const std::size_t definitions = xppParserStats::definitionCount(*this);
+        stats.record(STORE_CACHE, seconds, definitions, definitions, 0);
+    }
+}
+
+/**
+ * @brief Completes the statistics of a parse
+ *
+ * @par start: The start of the parse
+ */
+void xppParser::finishStats(xppParserStats::clock::time_point start) {
+    if (!config.stats) {
+        return;
+    }
+    stats.collect(*this);
+    stats.totalSeconds = xppParserStats::elapsed(start);
+}
+
+/**
+ * @brief Reparses the ode file after it has been edited
+ *
+ * @par error: If not null, errors are stored there instead of being printed
+ *
+ * @return False if the edited ode file contains an error
+ *
+ * In incremental mode only the statements that changed since the last parse
+ * are processed again. Their definitions are spliced into the model, while
+ * the definitions of unchanged statements, including their expanded arrays
+ * and computed tables, stay where they are and only their line numbers are
+ * adjusted, see spliceStatements. Without incremental mode the whole file is
+ * parsed again.
+ *
+ * If the edited file contains an error, the previous model and its statements
+ * are kept, so that the parser always holds the result of the last successful
+ * parse.
+ */
+bool xppParser::update(std::string *error) {
+    stats = xppParserStats();
+    const xppParserStats::clock::time_point start =
+            xppParserStats::start(config.stats ? &stats : nullptr);
+
+    /* The previous model, once it was replaced by an empty one */
+    optsCollection previousModel;
+    stringList previousTableFiles;
+    xppSymbolTable previousNames;
+    bool replaced = false;
+    auto replaceModel = [&]() {
+        std::swap(static_cast<optsCollection&>(*this), previousModel);
+        previousTableFiles.swap(tableFiles);
+        std::swap(usedNames, previousNames);
+        replaced = true;
+    };
+    const std::size_t previousSize = fileSize;
+    try {
+        readFile();
+
+        if (!config.incremental) {
+            replaceModel();
+            std::vector<parsedChunk> chunks =
+                    splitChunks(config.threads > 1 ? 4*config.threads : 1);
+            processChunks(chunks, config.threads);
+            mergeChunks(chunks);
+            finishStats(start);
+            return true;
+        }
+
+        /* Match the statements with those of the previous parse by their
+         * hash, preferably at the same position
+         */
+        const std::size_t none = std::numeric_limits<std::size_t>::max();
+        std::vector<std::size_t> bounds;
+        std::vector<statement> current = splitStatements(bounds);
+        std::vector<std::size_t> reusedFrom(current.size(), none);
+        std::vector<bool> matched(statements.size(), false);
+        for (std::size_t i = 0; i < std::min(current.size(), statements.size()); ++i) {
+            if (current[i].reusable && statements[i].reusable &&
+                current[i].hash == statements[i].hash) {
+                reusedFrom[i] = i;
+                matched[i] = true;
+            }
+        }
+        std::unordered_multimap<uint64_t, std::size_t> previous;
+        for (std::size_t j = 0; j < statements.size(); ++j) {
+            if (!matched[j] && statements[j].reusable) {
+                previous.emplace(statements[j].hash, j);
+            }
+        }
+        for (std::size_t i = 0; i < current.size() && !previous.empty(); ++i) {
+            if (reusedFrom[i] != none || !current[i].reusable) {
+                continue;
+            }
+            auto match = previous.find(current[i].hash);
+            if (match != previous.end()) {
+                reusedFrom[i] = match->second;
+                previous.erase(match);
+            }
+        }
+
+        /* Process only the changed statements */
+        std::vector<bool> changedStatements(current.size());
+        for (std::size_t i = 0; i < current.size(); ++i) {
+            changedStatements[i] = reusedFrom[i] == none;
+        }
+        std::vector<parsedChunk> changed = splitBlocks(bounds, changedStatements);
+        processChunks(changed, config.threads);
+
+        bool spliced = false;
+        try {
+            spliced = spliceStatements(current, reusedFrom, changed);
+        } catch (...) {
+            spliced = false;
+        }
+
+        /* Otherwise process the unchanged statements as well and merge all of
+         * them into an empty model, which reports errors exactly as a fresh
+         * parse would
+         */
+        if (!spliced) {
+            std::vector<bool> unchangedStatements(changedStatements.size());
+            for (std::size_t i = 0; i < current.size(); ++i) {
+                unchangedStatements[i] = !changedStatements[i];
+            }
+            std::vector<parsedChunk> unchanged = splitBlocks(bounds, unchangedStatements);
+            std::vector<parsedChunk> chunks;
+            chunks.reserve(current.size());
+            for (std::size_t i = 0, k = 0, l = 0; i < current.size(); ++i) {
+                chunks.push_back(std::move(changedStatements[i] ? changed[k++]
+                                                                : unchanged[l++]));
+            }
+            processChunks(chunks, config.threads);
+            replaceModel();
+            for (statement &next : current) {
+                next.references.clear();
+            }
+            mergeChunks(chunks, &current);
+            statements.swap(current);
+        }
+        lines.clear();
+        source.reset();
+        finishStats(start);
+        return true;
+    } catch (...) {
+        /* Restore the previous model */
+        if (replaced) {
+            std::swap(static_cast<optsCollection&>(*this), previousModel);
+            tableFiles.swap(previousTableFiles);
+            std::swap(usedNames, previousNames);
+        }
+        lines.clear();
+        source.reset();
+        fileSize = previousSize;
+        handleError(std::current_exception(), error);
+    }
+    return false;
+}
+
+/**
+ * @brief Processes the lines read so far and passes the definitions to a sink
+ *
+ * @par sink: The function that receives every extracted definition
+ * @par final: Flag whether the stream ended
+ *
+ * Unless the stream ended, the last statement is kept, as it might continue
+ * in the next block.
+ */
+void xppParser::streamLines(const optsSink &sink, bool final) {
+    std::vector<lineNumber> pending;
+    if (!final) {
+        auto last = lines.cbegin();
+        for (auto line = lines.cbegin(); line != lines.cend();
+             line = endOfBlock(line, lines.cend())) {
+            last = line;
+        }
+        const auto start = lines.begin() + std::distance(lines.cbegin(), last);
+        pending.assign(std::make_move_iterator(start),
+                       std::make_move_iterator(lines.end()));
+        lines.erase(start, lines.end());
+    }
+
+    if (!lines.empty()) {
+        std::vector<parsedChunk> chunks =
+                splitChunks(config.threads > 1 ? 4*config.threads : 1);
+        processChunks(chunks, config.threads);
+        mergeChunks(chunks);
+
+        const optsCollection::arrayList &arrays = optsCollection::arrays();
+        for (std::size_t type = 0; type < arrays.size(); ++type) {
+            for (const opts &opt : this->*arrays[type]) {
+                sink(static_cast<optsType>(type), opt);
+            }
+        }
+        if (!Wieners.Args.empty()) {
+            sink(WIENERS, Wieners);
+        }
+        static_cast<optsCollection&>(*this) = optsCollection();
+    }
+    lines.swap(pending);
+}
+
 /**
  * @brief Returns the different parsed objects and their definition
  */
@@ -2,10 +2,25 @@
 #define XPPPARSER_H
 #include <iostream>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <sstream>
 #include <stack>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -13,85 +28,289 @@
 #include "mpDefines.h"
 
 #include "keywordTrie.hpp"
+#include "xppCompactModel.h"
+#include "xppHash.h"
+#include "xppIndexExpression.h"
+#include "xppMappedFile.h"
+#include "xppModelCache.h"
 #include "xppParserDefines.h"
 #include "xppParserException.h"
+#include "xppParserStats.h"
+#include "xppStructuralIndex.h"
+#include "xppSymbolTable.h"
+#include "xppTableExpression.h"
+#include "xppTableFile.h"
 
-class xppParser {
+/* Settings that control how an ode file is parsed */
+struct xppParserConfig {
+    /* The number of threads used to process a single file */
+    unsigned	threads		= 1;
+
+    /* Keep the result of every statement, so that update() only has to
+     * process the statements that changed since the last parse
+     */
+    bool		incremental	= false;
+
+    /* If not empty, parsed models are stored in and loaded from binary images
+     * in this directory, so that unchanged files do not have to be parsed
+     */
+    std::string	cacheDirectory;
+
+    /* Keep array statements as one template per definition together with
+     * its index range instead of duplicating the lines for every index. The
+     * families are expanded by expandArray when they are needed.
+     */
+    bool		symbolicArrays	= false;
+
+    /* Record the time, line counts and memory of every phase of the parse,
+     * which are available through getStats()
+     */
+    bool		stats		= false;
+};
+
+class xppParser : private optsCollection {
 public:
-    xppParser(const std::string &fn);
+    /* Outcome of parsing a single file of a batch */
+    struct batchResult {
+        std::string	fileName;
+        std::size_t	bytes	= 0;
+        double		seconds	= 0.0;
+        std::string	error;
+    };
+
+    /* Outcome and throughput of parsing a batch of files */
+    struct batchSummary {
+        std::vector<batchResult> results;
+        std::size_t	bytes	= 0;
+        std::size_t	failed	= 0;
+        double		seconds	= 0.0;
+
+        /* Phases and definitions of all files, if xppParserConfig::stats is set */
+        xppParserStats	stats;
+
+        double filesPerSecond	 (void) const {return seconds > 0.0 ? results.size()/seconds : 0.0;}
+        double megabytesPerSecond(void) const {return seconds > 0.0 ? bytes/seconds/1.0e6 : 0.0;}
+    };
+
+    /* Receiver of the definitions that are extracted in streaming mode */
+    typedef std::function<void(optsType type, const opts &opt)> optsSink;
+
+    xppParser(const std::string &fn, unsigned threads = 1);
+    xppParser(const std::string &fn, const xppParserConfig &config);
     xppParser(const xppParser &parser);
+    xppParser(xppParser &&parser);
+
+    bool update (std::string *error = nullptr);
+
+    static batchSummary parseMany(const std::vector<std::string> &paths,
+                                  const xppParserConfig &config);
+    static optsArray expandArray(const optsArray &array);
+
+    static bool parseStream(std::istream &input, const optsSink &sink,
+                            const xppParserConfig &config = xppParserConfig(),
+                            std::string *error = nullptr);
 
     const optsArray getOptions (void) const {return Options;}
+    xppCompactModel getCompactModel (void) const {return xppCompactModel(*this);}
+    const xppParserStats &getStats (void) const {return stats;}
 
 private:
-    void expandArrays		(void);
+    /* Lines [first, last) of a chunk that stem from an array statement. The
+     * templates describe the lines of the statement. Symbolic families keep
+     * only the templates, otherwise they are repeated for every index.
+     */
+    struct arrayFamily {
+        std::size_t				first;
+        std::size_t				last;
+        std::vector<optsRange>	templates;
+    };
+
+    /* A name that has to be checked against the already used names. Either it
+     * is a new definition, or it must refer to an existing one. Names of
+     * symbolic array families are checked for every index.
+     */
+    struct pendingName {
+        std::string			name;
+        const lineNumber   *line;
+        size_t				pos;
+        bool				declare;
+        const optsRange	   *range;
+    };
+
+    /* The mapped ode file together with the structural index of its content,
+     * which the lines that are used as they appear in the file point into
+     */
+    struct sourceFile {
+        explicit sourceFile(const std::string &fn);
+
+        xppMappedFile		file;
+        xppStructuralIndex	index;
+    };
+
+    /* Consecutive lines of the ode file that are processed independently of
+     * the others. Lines always start with a complete statement, so that array
+     * blocks and markov processes are never split between two chunks.
+     */
+    struct parsedChunk : public optsCollection {
+        std::vector<lineNumber>	 lines;
+
+        /* The ode file and its index the lines are views into */
+        std::shared_ptr<const sourceFile> source;
+
+        std::vector<pendingName> names;
+        std::vector<arrayFamily> families;
+        const optsRange			*range			 = nullptr;
+        stringList				 tableFiles;
+        xppParserStats			*stats			 = nullptr;
+        std::exception_ptr		 error;
+
+        /* Threads available to the statements of the chunk, which is 1 while
+         * the chunks themselves are processed in parallel
+         */
+        unsigned				 threads		 = 1;
+        bool					 expansionFailed = false;
+        bool					 processed		 = false;
+    };
+
+    /* A statement of the ode file in incremental mode, which is identified by
+     * the hash of its lines. Its definitions are kept only in the model, where
+     * they form consecutive ranges of the opts arrays, the wiener processes,
+     * the table files and the used names. The statement records the length of
+     * every range, so that its definitions can be found without storing them.
+     */
+    struct statement {
+        uint64_t	hash		= 0;
+        unsigned	firstLine	= 0;
+        bool		reusable	= true;
+
+        std::array<unsigned, std::tuple_size<optsCollection::arrayList>::value> definitions{};
+        unsigned	wieners		= 0;
+        unsigned	tableFiles	= 0;
+        unsigned	names		= 0;
+
+        /* Names that must have been declared by a preceding statement */
+        stringList	references;
+    };
+
+    /* Functions of a library together with the table and library files it
+     * refers to, including those of nested libraries
+     */
+    struct parsedLibrary {
+        optsArray	functions;
+        stringList	tableFiles;
+    };
+
+    xppParser(const std::string &fn, const xppParserConfig &config,
+              std::string *error);
+    explicit xppParser(const xppParserConfig &config);
+
+    static void handleError	(std::exception_ptr exception, std::string *error);
+
+    static const keywordTrie::trie &getKeywordTrie(void);
+
+    void expandArrays		(parsedChunk &chunk);
     void expandArrayLines	(std::vector<lineNumber> &lines,
                              const std::vector<lineNumber> &expressions,
-                             const int idx);
-    void extractDefinition	(void);
-    void extractExport		(void);
-    void extractGlobal		(void);
-    void extractMarkov		(void);
-    void extractTable		(void);
-    void extractWiener		(void);
-    void initializeTries	(void);
+                             const int start, const int end);
+    void extractDefinition	(const lineNumber &line, parsedChunk &chunk);
+    void extractExport		(const lineNumber &line, parsedChunk &chunk);
+    void extractGlobal		(const lineNumber &line, parsedChunk &chunk);
+    void extractLibrary		(const lineNumber &line, parsedChunk &chunk);
+    void extractLines		(parsedChunk &chunk);
+    void extractMarkov		(std::vector<lineNumber>::const_iterator &line,
+                             parsedChunk &chunk);
+    void extractTable		(const lineNumber &line, parsedChunk &chunk);
+    void extractWiener		(const lineNumber &line, parsedChunk &chunk);
+    bool loadCache			(void);
+    std::shared_ptr<const parsedLibrary> loadLibrary(const std::string &fn);
     void readFile			(void);
-    void removeComments		(void);
-    void removeWhitespace	(void);
+    bool readLines			(const char *data, std::size_t size,
+                             const xppStructuralIndex &index,
+                             unsigned &lineCount, bool views);
+    void removeWhitespace	(std::vector<lineNumber> &lines);
+    void storeCache			(void);
+    void finishStats		(xppParserStats::clock::time_point start);
+    void recordSplit		(xppParserStats::clock::time_point start,
+                             std::size_t linesIn,
+                             const std::vector<parsedChunk> &chunks);
     void summarizeOde		(void);
 
+    /* Chunked processing */
+    std::vector<statement>	 splitStatements(std::vector<std::size_t> &bounds);
+    std::vector<parsedChunk> splitBlocks	(const std::vector<std::size_t> &bounds,
+                                             const std::vector<bool> &selected);
+    std::vector<parsedChunk> splitChunks	(unsigned numChunks);
+    void processChunk		(parsedChunk &chunk);
+    void processChunks		(std::vector<parsedChunk> &chunks, unsigned threads);
+    void mergeChunks		(std::vector<parsedChunk> &chunks,
+                             std::vector<statement> *merged = nullptr);
+    bool spliceStatements	(std::vector<statement> &current,
+                             const std::vector<std::size_t> &reusedFrom,
+                             std::vector<parsedChunk> &changed);
+    void streamLines		(const optsSink &sink, bool final);
+
     /* Helper functions */
-    void checkBrackets		(void);
-    void checkName			(const std::string &name, const lineNumber &line, size_t pos);
+    void checkBrackets		(const lineNumber &line);
+    void checkName			(const std::string &name, const lineNumber &line,
+                             size_t pos, parsedChunk &chunk);
+    void declareName		(const std::string &name, const pendingName &pending);
+    void resolveSymbols		(optsCollection &collection) const;
+    void expandSymbolicArrays(void);
 
-    stringList  getList		(const std::string &line, unsigned ln,
-                             const std::string &closure, const std::string &delim);
+    std::vector<lineNumber>::const_iterator endOfBlock(
+            std::vector<lineNumber>::const_iterator line,
+            std::vector<lineNumber>::const_iterator end);
+
+    stringList  getList		(const lineNumber &line, size_t first, size_t last,
+                             char closure, char delim);
+    static void analyseIndices(const std::string &text, optsRange &range);
+    static void evaluateIndices(const std::string &expr, const lineNumber &line,
+                                size_t pos, int start, int end,
+                                std::vector<long long> &values);
+    static stringList expandIndices(const std::string &text,
+                                    const lineNumber &line, int start, int end);
     std::string getNextExpr (const lineNumber &line, size_t &pos1,size_t &pos2);
     std::string getNextWord (const lineNumber &line, size_t &pos1,size_t &pos2);
 
     bool isNumeric			(const std::string &str);
 
-    keywordTrie::result keywordSearch(const std::string &key,
-                                      const char &character);
+    keywordTrie::match keywordSearch(const std::string &key,
+                                     const xppLineText &line, size_t pos);
 
     /* Filename of the ode file */
     const std::string		fileName;
 
+    /* Settings of the parser */
+    const xppParserConfig	config;
+
+    /* Size of the ode file in bytes */
+    std::size_t				fileSize = 0;
+
+    /* Hash of the ode file contents that identifies its cached image */
+    uint64_t				cacheKey = 0;
+
+    /* Table and library files that are read by the ode file */
+    stringList				tableFiles;
+
     /* Vector containing the individual lines from the ode file */
     std::vector<lineNumber>	lines;
 
+    /* The mapped ode file and its index the lines are views into. It is
+     * handed over to the chunks together with the lines.
+     */
+    std::shared_ptr<const sourceFile> source;
+
     /* Trie of xpp keyword */
-    keywordTrie::trie		keywords;
-
-    /* Trie of xpp options */
-    keywordTrie::trie		options;
-
-    /* Trie of reserved names */
-    keywordTrie::trie		reservedNames;
-
-    /* Trie of the already used names */
-    keywordTrie::trie		usedNames;
-
-    /* Options arrays */
-    optsArray Algebraic;
-    optsArray Auxiliar;
-    optsArray Boundaries;
-    optsArray Constants;
-    optsArray Equations;
-    optsArray Exports;
-    optsArray Functions;
-    optsArray Globals;
-    optsArray InitConds;
-    optsArray Temporaries;
-    optsArray Markovs;
-    optsArray Numbers;
-    optsArray Options;
-    optsArray Parameters;
-    optsArray Special;
-    optsArray Sets;
-    optsArray Tables;
-    optsArray Volterra;
-    opts	  Wieners;
+    const keywordTrie::trie	&keywords;
+
+    /* The already used names */
+    xppSymbolTable			usedNames;
+
+    /* The statements of the last parse in incremental mode */
+    std::vector<statement>	statements;
+
+    /* Instrumentation of the last parse, see xppParserConfig::stats */
+    xppParserStats			stats;
 
     friend class xppEvaluator;
 };
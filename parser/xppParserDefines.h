@@ -1,11 +1,46 @@
 #ifndef XPPPARSERDEFINES_H
 #define XPPPARSERDEFINES_H
 
+#include <array>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "xppLineText.h"
+#include "xppPerfectHash.h"
+
+/* Affine index Stride*j+Offset of an array reference Array[...] within an
+ * array statement. Array is empty for brackets that are not preceded by a
+ * name, e.g. [j+1] used as a plain number.
+ */
+struct optsIndex {
+    std::string	Array;
+    int			Stride	= 0;
+    int			Offset	= 0;
+};
+
+/* Array statement a definition stems from. All definitions of one array
+ * statement share the line of the statement, which identifies the family.
+ * Symbolic families are templates for all j in [Start, End], otherwise the
+ * definition is the member for j = Index. Indices lists the index expressions
+ * of the template in order of appearance, which describes the neighbour
+ * structure of the array. Affine is false if any index expression is not
+ * affine in j and therefore missing from Indices.
+ */
+struct optsRange {
+    unsigned				Line	 = 0;
+    int						Start	 = 0;
+    int						End		 = 0;
+    int						Index	 = 0;
+    bool					Symbolic = false;
+    bool					Affine	 = true;
+    std::vector<optsIndex>	Indices;
+};
+
+/* Symbol ID of names that are not declared in the ode file */
+const unsigned noSymbol = static_cast<unsigned>(-1);
+
 /* Basic structure that contains the textual information of an expression*/
 struct opts {
     unsigned					Line;
@@ -13,27 +48,121 @@ struct opts {
     std::string					Expr;
     std::vector<std::string>	Args;
 
-    explicit opts () {}
+    /* ID of Name among the declared names of the ode file, or noSymbol */
+    unsigned					Symbol	= noSymbol;
+
+    /* Array statement the definition stems from. For symbolic families Name,
+     * Expr and Args are templates whose bracketed index expressions depend on j
+     */
+    optsRange					Range;
+
+    /* Sampled values of a table on the grid between the bounds in Args */
+    std::vector<double>			Values;
+
+    explicit opts () : Line(0) {}
     explicit opts (const unsigned line) : Line(line) {}
     explicit opts (const opts &opt)
-        : Line(opt.Line), Name(opt.Name), Expr(opt.Expr), Args(opt.Args) {}
+        : Line(opt.Line), Name(opt.Name), Expr(opt.Expr), Args(opt.Args),
+          Symbol(opt.Symbol), Range(opt.Range), Values(opt.Values) {}
+    opts (opts &&opt) = default;
+
+    opts &operator= (const opts &opt) = default;
+    opts &operator= (opts &&opt) = default;
+
+    bool isArray	(void) const {return Range.Line != 0;}
+    bool isSymbolic (void) const {return Range.Symbolic;}
 };
 
 /* Array of opts structures */
 typedef std::vector<opts> optsArray;
 
+/* Kinds of extracted definitions in the order of optsCollection::arrays() */
+enum optsType {
+    ALGEBRAIC,
+    AUXILIAR,
+    BOUNDARIES,
+    CONSTANTS,
+    EQUATIONS,
+    EXPORTS,
+    FUNCTIONS,
+    GLOBALS,
+    INITCONDS,
+    TEMPORARIES,
+    MARKOVS,
+    NUMBERS,
+    OPTIONS,
+    PARAMETERS,
+    SPECIAL,
+    SETS,
+    TABLES,
+    VOLTERRA,
+    WIENERS
+};
+
+/* Collection of all opts arrays that are extracted from an ode file */
+struct optsCollection {
+    optsArray Algebraic;
+    optsArray Auxiliar;
+    optsArray Boundaries;
+    optsArray Constants;
+    optsArray Equations;
+    optsArray Exports;
+    optsArray Functions;
+    optsArray Globals;
+    optsArray InitConds;
+    optsArray Temporaries;
+    optsArray Markovs;
+    optsArray Numbers;
+    optsArray Options;
+    optsArray Parameters;
+    optsArray Special;
+    optsArray Sets;
+    optsArray Tables;
+    optsArray Volterra;
+    opts	  Wieners;
+
+    /* Member pointers to all opts arrays, so that they can be processed in a
+     * loop. Wieners is not included as it is a single opts structure.
+     */
+    typedef std::array<optsArray optsCollection::*, 18> arrayList;
+    static const arrayList &arrays(void) {
+        static const arrayList list = {{
+            &optsCollection::Algebraic,
+            &optsCollection::Auxiliar,
+            &optsCollection::Boundaries,
+            &optsCollection::Constants,
+            &optsCollection::Equations,
+            &optsCollection::Exports,
+            &optsCollection::Functions,
+            &optsCollection::Globals,
+            &optsCollection::InitConds,
+            &optsCollection::Temporaries,
+            &optsCollection::Markovs,
+            &optsCollection::Numbers,
+            &optsCollection::Options,
+            &optsCollection::Parameters,
+            &optsCollection::Special,
+            &optsCollection::Sets,
+            &optsCollection::Tables,
+            &optsCollection::Volterra
+        }};
+        return list;
+    }
+};
+
 /* Array of strings */
 typedef std::vector<std::string> stringList;
 
 /* Pair containing a parsed line and the original line number in the ode file.
- * This is mainly usefull for debugging if an error is thrown.
+ * This is mainly usefull for debugging if an error is thrown. The text is a
+ * view into the ode file unless the line had to be rewritten.
  */
-typedef std::pair<std::string, unsigned> lineNumber;
+typedef std::pair<xppLineText, unsigned> lineNumber;
 
-/* Vector containing the keywords utilized by xppaut. We cannot use a set here,
- * as that would change the ordering of the symbols
+/* Keywords utilized by xppaut. We cannot use a set here, as that would change
+ * the ordering of the symbols
  */
-static const std::vector<std::string> xppKeywords = {
+static constexpr const char *xppKeywords[] = {
     "!",
     "(t+1)",
     "'",
@@ -69,8 +198,8 @@ static const std::set<std::string> xppOperators {
     "**"
 };
 
-/* Set of the reserved function names */
-static const std::set<std::string> xppReservedNames {
+/* Reserved function names */
+static constexpr const char *xppReservedNames[] = {
     "sin",
     "cos",
     "tan",
@@ -114,8 +243,8 @@ static const std::set<std::string> xppReservedNames {
     "not"
 };
 
-/* Set of the options that can be modified in an ode file */
-static const std::set<std::string> xppOptionNames {
+/* Options that can be modified in an ode file */
+static constexpr const char *xppOptionNames[] = {
     "QUIET",
     "LOGFILE",
     "OUTPUT",
@@ -260,5 +389,12 @@ static const std::set<std::string> xppOptionNames {
     "BELL"
 };
 
+/* Perfect hash tables for the classification of names. Options are case
+ * insensitive.
+ */
+static constexpr auto xppKeywordTable		= xppMakePerfectHash(xppKeywords);
+static constexpr auto xppReservedNameTable	= xppMakePerfectHash(xppReservedNames);
+static constexpr auto xppOptionNameTable	= xppMakePerfectHash(xppOptionNames, true);
+
 #endif // XPPPARSERDEFINES_H
 
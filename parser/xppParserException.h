@@ -99,7 +99,7 @@ public:
             break;
         }
         m_msg += " in line " + std::to_string(line.second) + ":\n";
-        m_msg += line.first + "\n";
+        m_msg += line.first.str() + "\n";
         m_msg += std::string(pos, ' ') + "^\n";
     }
 
@@ -0,0 +1,227 @@
+#include "xppParserStats.h"
+
+#include <iomanip>
+
+namespace {
+
+/* Names of the opts arrays indexed by optsType */
+const char *const typeNames[] = {
+    "algebraic",
+    "auxiliar",
+    "boundaries",
+    "constants",
+    "equations",
+    "exports",
+    "functions",
+    "globals",
+    "initconds",
+    "temporaries",
+    "markovs",
+    "numbers",
+    "options",
+    "parameters",
+    "special",
+    "sets",
+    "tables",
+    "volterra",
+    "wieners"
+};
+
+} // namespace
+
+/**
+ * @brief xppParserStats::record Adds a single run of a phase
+ * @param phase The phase that was run.
+ * @param seconds The wall time of the run.
+ * @param linesIn The lines that entered the phase.
+ * @param linesOut The lines or definitions that left the phase.
+ * @param bytes The heap memory held by the output of the phase.
+ */
+void xppParserStats::record(xppPhase phase, double seconds, std::size_t linesIn,
+                            std::size_t linesOut, std::size_t bytes) {
+    xppPhaseStats &target = phases[phase];
+    ++target.calls;
+    target.seconds	+= seconds;
+    target.linesIn	+= linesIn;
+    target.linesOut += linesOut;
+    target.bytes	+= bytes;
+}
+
+/**
+ * @brief xppParserStats::merge Adds the phases and definitions recorded by
+ * another thread or file
+ */
+void xppParserStats::merge(const xppParserStats &other) {
+    for (std::size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        const xppPhaseStats &source = other.phases[phase];
+        xppPhaseStats &target = phases[phase];
+        target.calls	+= source.calls;
+        target.seconds	+= source.seconds;
+        target.linesIn	+= source.linesIn;
+        target.linesOut += source.linesOut;
+        target.bytes	+= source.bytes;
+    }
+    for (std::size_t type = 0; type < definitions.size(); ++type) {
+        definitions[type]		+= other.definitions[type];
+        definitionBytes[type]	+= other.definitionBytes[type];
+    }
+}
+
+/**
+ * @brief xppParserStats::collect Counts the definitions of a parsed model
+ */
+void xppParserStats::collect(const optsCollection &collection) {
+    const optsCollection::arrayList &arrays = optsCollection::arrays();
+    for (std::size_t type = 0; type < arrays.size(); ++type) {
+        const optsArray &array = collection.*arrays[type];
+        definitions[type] = array.size();
+        definitionBytes[type] = heapBytes(array);
+    }
+    definitions[WIENERS] = collection.Wieners.Args.size();
+    definitionBytes[WIENERS] = heapBytes(collection.Wieners);
+}
+
+/**
+ * @brief xppParserStats::print Writes the counters as a table
+ */
+void xppParserStats::print(std::ostream &stream) const {
+    const std::ios::fmtflags flags = stream.flags();
+    stream << std::left << std::setw(20) << "phase" << std::right
+           << std::setw(8) << "calls" << std::setw(12) << "seconds"
+           << std::setw(12) << "lines in" << std::setw(12) << "lines out"
+           << std::setw(14) << "bytes" << "\n";
+    for (std::size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        const xppPhaseStats &stats = phases[phase];
+        if (stats.calls == 0) {
+            continue;
+        }
+        stream << std::left << std::setw(20) << phaseName(xppPhase(phase))
+               << std::right << std::setw(8) << stats.calls
+               << std::setw(12) << std::fixed << std::setprecision(6) << stats.seconds
+               << std::setw(12) << stats.linesIn << std::setw(12) << stats.linesOut
+               << std::setw(14) << stats.bytes << "\n";
+    }
+
+    stream << "\n" << std::left << std::setw(20) << "definitions" << std::right
+           << std::setw(8) << "count" << std::setw(14) << "bytes" << "\n";
+    for (std::size_t type = 0; type <= WIENERS; ++type) {
+        if (definitions[type] == 0) {
+            continue;
+        }
+        stream << std::left << std::setw(20) << typeNames[type] << std::right
+               << std::setw(8) << definitions[type]
+               << std::setw(14) << definitionBytes[type] << "\n";
+    }
+    stream << "\ntotal " << std::fixed << std::setprecision(6)
+           << totalSeconds << " s" << std::endl;
+    stream.flags(flags);
+}
+
+/**
+ * @brief xppParserStats::phaseName Returns the name of a phase
+ */
+const char *xppParserStats::phaseName(xppPhase phase) {
+    switch (phase) {
+    case LOAD_CACHE:			return "loadCache";
+    case READ_FILE:				return "readFile";
+    case SPLIT_CHUNKS:			return "splitChunks";
+    case REMOVE_WHITESPACE:		return "removeWhitespace";
+    case EXPAND_ARRAYS:			return "expandArrays";
+    case EXTRACT_DEFINITION:	return "extractDefinition";
+    case EXTRACT_EXPORT:		return "extractExport";
+    case EXTRACT_GLOBAL:		return "extractGlobal";
+    case EXTRACT_LIBRARY:		return "extractLibrary";
+    case EXTRACT_MARKOV:		return "extractMarkov";
+    case EXTRACT_TABLE:			return "extractTable";
+    case EXTRACT_WIENER:		return "extractWiener";
+    case MERGE_CHUNKS:			return "mergeChunks";
+    case STORE_CACHE:			return "storeCache";
+    default:					return "unknown";
+    }
+}
+
+/**
+ * @brief xppParserStats::definitionCount Returns the number of definitions
+ * in all opts arrays
+ */
+std::size_t xppParserStats::definitionCount(const optsCollection &collection) {
+    std::size_t count = collection.Wieners.Args.size();
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        count += (collection.*array).size();
+    }
+    return count;
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by a string,
+ * which is zero for short strings that are stored in place
+ */
+std::size_t xppParserStats::heapBytes(const std::string &str) {
+    const char *object = reinterpret_cast<const char*>(&str);
+    const bool inPlace = str.data() >= object && str.data() < object + sizeof(str);
+    return inPlace ? 0 : str.capacity() + 1;
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by the text of
+ * a line and its index, which is zero for views into the ode file
+ */
+std::size_t xppParserStats::heapBytes(const xppLineText &text) {
+    const std::string *copy = text.ownedText();
+    if (!copy) {
+        return 0;
+    }
+    return sizeof(std::string) + heapBytes(*copy) + sizeof(xppStructuralIndex) +
+           text.ownedIndex()->numWords()*xppStructuralIndex::NUM_CLASSES*sizeof(uint64_t);
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by a definition
+ */
+std::size_t xppParserStats::heapBytes(const opts &opt) {
+    std::size_t bytes = heapBytes(opt.Name) + heapBytes(opt.Expr) +
+                        opt.Args.capacity()*sizeof(std::string) +
+                        opt.Range.Indices.capacity()*sizeof(optsIndex) +
+                        opt.Values.capacity()*sizeof(double);
+    for (const std::string &arg : opt.Args) {
+        bytes += heapBytes(arg);
+    }
+    for (const optsIndex &index : opt.Range.Indices) {
+        bytes += heapBytes(index.Array);
+    }
+    return bytes;
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by an opts array
+ */
+std::size_t xppParserStats::heapBytes(const optsArray &array) {
+    std::size_t bytes = array.capacity()*sizeof(opts);
+    for (const opts &opt : array) {
+        bytes += heapBytes(opt);
+    }
+    return bytes;
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by all opts
+ * arrays
+ */
+std::size_t xppParserStats::heapBytes(const optsCollection &collection) {
+    std::size_t bytes = heapBytes(collection.Wieners);
+    for (optsArray optsCollection::*array : optsCollection::arrays()) {
+        bytes += heapBytes(collection.*array);
+    }
+    return bytes;
+}
+
+/**
+ * @brief xppParserStats::heapBytes Returns the heap memory held by lines
+ */
+std::size_t xppParserStats::heapBytes(const std::vector<lineNumber> &lines) {
+    std::size_t bytes = lines.capacity()*sizeof(lineNumber);
+    for (const lineNumber &line : lines) {
+        bytes += heapBytes(line.first);
+    }
+    return bytes;
+}
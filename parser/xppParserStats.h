@@ -0,0 +1,95 @@
+#ifndef XPPPARSERSTATS_H
+#define XPPPARSERSTATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "xppParserDefines.h"
+
+/* Phases of the parsing pipeline in the order they are run */
+enum xppPhase {
+    LOAD_CACHE,
+    READ_FILE,
+    SPLIT_CHUNKS,
+    REMOVE_WHITESPACE,
+    EXPAND_ARRAYS,
+    EXTRACT_DEFINITION,
+    EXTRACT_EXPORT,
+    EXTRACT_GLOBAL,
+    EXTRACT_LIBRARY,
+    EXTRACT_MARKOV,
+    EXTRACT_TABLE,
+    EXTRACT_WIENER,
+    MERGE_CHUNKS,
+    STORE_CACHE,
+    PHASE_COUNT
+};
+
+/* Counters of a single phase. Lines are the lines entering and leaving the
+ * phase, for the extraction phases the lines that were read and the
+ * definitions that were created. Bytes is the heap memory held by the output
+ * of the phase. Phases that run per chunk sum the time of all threads.
+ */
+struct xppPhaseStats {
+    unsigned	calls		= 0;
+    double		seconds		= 0.0;
+    std::size_t	linesIn		= 0;
+    std::size_t	linesOut	= 0;
+    std::size_t	bytes		= 0;
+};
+
+/* Instrumentation of the parsing pipeline, which is only filled if
+ * xppParserConfig::stats is set. Otherwise every probe is a single branch.
+ */
+struct xppParserStats {
+    typedef std::chrono::steady_clock clock;
+
+    /* Counters of all phases indexed by xppPhase */
+    std::array<xppPhaseStats, PHASE_COUNT> phases;
+
+    /* Number of definitions and the heap memory they hold indexed by
+     * optsType. For WIENERS these are the individual Wiener processes.
+     */
+    std::array<std::size_t, WIENERS+1> definitions{};
+    std::array<std::size_t, WIENERS+1> definitionBytes{};
+
+    /* Wall time of the whole parse */
+    double totalSeconds = 0.0;
+
+    /**
+     * @brief start Returns the start time of a probe, if stats are recorded
+     */
+    static clock::time_point start(const xppParserStats *stats) {
+        return stats ? clock::now() : clock::time_point();
+    }
+
+    /**
+     * @brief elapsed Returns the seconds since the start of a probe
+     */
+    static double elapsed(clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    void record		(xppPhase phase, double seconds, std::size_t linesIn,
+                     std::size_t linesOut, std::size_t bytes);
+    void merge		(const xppParserStats &other);
+    void collect	(const optsCollection &collection);
+    void print		(std::ostream &stream) const;
+
+    static const char *phaseName (xppPhase phase);
+
+    static std::size_t definitionCount (const optsCollection &collection);
+
+    static std::size_t heapBytes (const std::string &str);
+    static std::size_t heapBytes (const xppLineText &text);
+    static std::size_t heapBytes (const opts &opt);
+    static std::size_t heapBytes (const optsArray &array);
+    static std::size_t heapBytes (const optsCollection &collection);
+    static std::size_t heapBytes (const std::vector<lineNumber> &lines);
+};
+
+#endif // XPPPARSERSTATS_H
@@ -0,0 +1,163 @@
+#ifndef XPPPERFECTHASH_H
+#define XPPPERFECTHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/* Perfect hash table of a fixed set of keys, which is built at compile time.
+ * Every key is hashed into a bucket, and the displacement of the bucket
+ * selects a second hash that places the key into its slot. The displacements
+ * are chosen such that no two keys share a slot, so a lookup costs two hashes
+ * and a single comparison and never allocates. Optionally keys are compared
+ * ignoring the case of ASCII letters.
+ */
+template<std::size_t N, std::size_t Slots>
+class xppPerfectHash {
+    static_assert(Slots >= 2*N && (Slots & (Slots-1)) == 0,
+                  "The number of slots must be a power of two with room to spare");
+
+public:
+    constexpr xppPerfectHash(const char *const (&keys)[N], bool foldCase)
+        : keys(keys), sizes{}, slots{}, displacements{}, foldCase(foldCase)
+    {
+        std::size_t buckets[N] = {};
+        std::size_t bucketSizes[Buckets] = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            while (keys[i][sizes[i]] != '\0') {
+                ++sizes[i];
+            }
+            for (std::size_t j = 0; j < i; ++j) {
+                if (equal(j, keys[i], sizes[i])) {
+                    throw std::logic_error("Duplicated key in perfect hash table");
+                }
+            }
+            buckets[i] = hash(keys[i], sizes[i], 0) & (Buckets-1);
+            ++bucketSizes[buckets[i]];
+        }
+        for (std::size_t slot = 0; slot < Slots; ++slot) {
+            slots[slot] = -1;
+        }
+
+        /* Place the largest buckets first, while most slots are still free */
+        for (std::size_t count = N; count > 0; --count) {
+            for (std::size_t bucket = 0; bucket < Buckets; ++bucket) {
+                if (bucketSizes[bucket] == count) {
+                    placeBucket(bucket, buckets);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief find Looks up a key
+     * @return The index of the key in the key list or -1 if it is unknown.
+     */
+    int find (const char *str, std::size_t size) const {
+        const uint32_t bucket = hash(str, size, 0) & (Buckets-1);
+        const int index = slots[hash(str, size, displacements[bucket]) & (Slots-1)];
+        return index >= 0 && equal(index, str, size) ? index : -1;
+    }
+    int  find		(const std::string &str) const {return find(str.data(), str.size());}
+    bool contains	(const std::string &str) const {return find(str) >= 0;}
+
+private:
+    static constexpr std::size_t Buckets = Slots/4 > 0 ? Slots/4 : 1;
+
+    static constexpr char fold (char c, bool foldCase) {
+        return foldCase && c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+    }
+
+    constexpr uint32_t hash (const char *str, std::size_t size, uint32_t seed) const {
+        /* FNV-1a with a final mix, so that the low bits depend on all bytes */
+        uint32_t h = 2166136261u ^ (seed * 2654435761u);
+        for (std::size_t i = 0; i < size; ++i) {
+            h ^= static_cast<unsigned char>(fold(str[i], foldCase));
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        return h;
+    }
+
+    constexpr bool equal (std::size_t index, const char *str, std::size_t size) const {
+        if (sizes[index] != size) {
+            return false;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            if (fold(keys[index][i], foldCase) != fold(str[i], foldCase)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* Searches the first displacement that puts all keys of a bucket into
+     * free and distinct slots
+     */
+    constexpr void placeBucket (std::size_t bucket, const std::size_t (&buckets)[N]) {
+        for (uint32_t displacement = 1; displacement != 0; ++displacement) {
+            std::size_t chosen[N] = {};
+            std::size_t count = 0;
+            bool fits = true;
+            for (std::size_t i = 0; i < N && fits; ++i) {
+                if (buckets[i] != bucket) {
+                    continue;
+                }
+                const std::size_t slot = hash(keys[i], sizes[i], displacement) & (Slots-1);
+                fits = slots[slot] < 0;
+                for (std::size_t j = 0; j < count && fits; ++j) {
+                    fits = chosen[j] != slot;
+                }
+                chosen[count++] = slot;
+            }
+            if (fits) {
+                count = 0;
+                for (std::size_t i = 0; i < N; ++i) {
+                    if (buckets[i] == bucket) {
+                        slots[chosen[count++]] = static_cast<short>(i);
+                    }
+                }
+                displacements[bucket] = displacement;
+                return;
+            }
+        }
+        throw std::logic_error("No perfect hash function found");
+    }
+
+    /* The keys and their lengths */
+    const char *const  *keys;
+    std::size_t			sizes[N];
+
+    /* Index of the key in every slot or -1 if the slot is empty */
+    short				slots[Slots];
+
+    /* Seed of the slot hash of every bucket */
+    uint32_t			displacements[Buckets];
+
+    /* Flag whether the case of letters is ignored */
+    bool				foldCase;
+};
+
+/**
+ * @brief xppPerfectHashSlots Returns the smallest power of two that is at least
+ * twice the number of keys
+ */
+constexpr std::size_t xppPerfectHashSlots(std::size_t count) {
+    return count <= 1 ? 2 : 2*xppPerfectHashSlots((count+1)/2);
+}
+
+/**
+ * @brief xppMakePerfectHash Builds the perfect hash table of a key list
+ * @param keys The keys, which must be distinct.
+ * @param foldCase Flag whether the case of letters is ignored.
+ */
+template<std::size_t N>
+constexpr xppPerfectHash<N, xppPerfectHashSlots(N)>
+xppMakePerfectHash(const char *const (&keys)[N], bool foldCase = false) {
+    return xppPerfectHash<N, xppPerfectHashSlots(N)>(keys, foldCase);
+}
+
+#endif // XPPPERFECTHASH_H
@@ -0,0 +1,294 @@
+#include "xppStructuralIndex.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define XPP_HAVE_SSE2
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define XPP_HAVE_AVX2
+#endif
+
+namespace {
+
+/**
+ * @brief countTrailingZeros Position of the lowest set bit of a nonzero word
+ */
+inline unsigned countTrailingZeros(uint64_t word) {
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned count = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * @brief classifyScalar Classifies a block of 64 bytes one byte at a time
+ * @param block Pointer to the 64 bytes.
+ * @param masks The resulting bitmaps, one per character class.
+ */
+void classifyScalar(const char *block, uint64_t *masks) {
+    for (unsigned i = 0; i < 64; ++i) {
+        const uint64_t bit = uint64_t(1) << i;
+        switch (block[i]) {
+        case '\n':
+            masks[xppStructuralIndex::NEWLINE] |= bit;
+            break;
+        case '#':
+            masks[xppStructuralIndex::COMMENT] |= bit;
+            break;
+        case '(':
+        case ')':
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+            masks[xppStructuralIndex::BRACKET] |= bit;
+            break;
+        case ' ':
+        case '\t':
+        case '\f':
+        case '\v':
+        case '\r':
+            masks[xppStructuralIndex::WHITESPACE] |= bit;
+            break;
+        case '=':
+            masks[xppStructuralIndex::EQUALS] |= bit;
+            break;
+        case ',':
+            masks[xppStructuralIndex::COMMA] |= bit;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+#ifdef XPP_HAVE_SSE2
+/**
+ * @brief classifySSE2 Classifies a block of 64 bytes in four 16 byte lanes
+ * @param block Pointer to the 64 bytes.
+ * @param masks The resulting bitmaps, one per character class.
+ */
+void classifySSE2(const char *block, uint64_t *masks) {
+    for (unsigned k = 0; k < 4; ++k) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16*k));
+        const __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        const __m128i comment = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+        const __m128i bracket =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('(')),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8(')'))),
+                             _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')),
+                                                       _mm_cmpeq_epi8(v, _mm_set1_epi8(']'))),
+                                          _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')),
+                                                       _mm_cmpeq_epi8(v, _mm_set1_epi8('}')))));
+        /* '\t', '\v', '\f' and '\r' are the consecutive range [9, 13] without
+         * the newline, so test for it with a single unsigned comparison.
+         */
+        const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+        const __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)),
+                                               shifted);
+        const __m128i whitespace =
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                             _mm_andnot_si128(newline, inRange));
+        const __m128i equals = _mm_cmpeq_epi8(v, _mm_set1_epi8('='));
+        const __m128i comma  = _mm_cmpeq_epi8(v, _mm_set1_epi8(','));
+        const unsigned shift = 16*k;
+        masks[xppStructuralIndex::NEWLINE]    |= uint64_t(unsigned(_mm_movemask_epi8(newline)))    << shift;
+        masks[xppStructuralIndex::COMMENT]    |= uint64_t(unsigned(_mm_movemask_epi8(comment)))    << shift;
+        masks[xppStructuralIndex::BRACKET]    |= uint64_t(unsigned(_mm_movemask_epi8(bracket)))    << shift;
+        masks[xppStructuralIndex::WHITESPACE] |= uint64_t(unsigned(_mm_movemask_epi8(whitespace))) << shift;
+        masks[xppStructuralIndex::EQUALS]     |= uint64_t(unsigned(_mm_movemask_epi8(equals)))     << shift;
+        masks[xppStructuralIndex::COMMA]      |= uint64_t(unsigned(_mm_movemask_epi8(comma)))      << shift;
+    }
+}
+#endif
+
+#ifdef XPP_HAVE_AVX2
+/**
+ * @brief classifyAVX2 Classifies a block of 64 bytes in two 32 byte lanes
+ * @param block Pointer to the 64 bytes.
+ * @param masks The resulting bitmaps, one per character class.
+ */
+__attribute__((target("avx2")))
+void classifyAVX2(const char *block, uint64_t *masks) {
+    for (unsigned k = 0; k < 2; ++k) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32*k));
+        const __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        const __m256i comment = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'));
+        const __m256i bracket =
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('(')),
+                                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(')'))),
+                                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('[')),
+                                                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(']'))),
+                                                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')),
+                                                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')))));
+        const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+        const __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)),
+                                                  shifted);
+        const __m256i whitespace =
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                _mm256_andnot_si256(newline, inRange));
+        const __m256i equals = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('='));
+        const __m256i comma  = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','));
+        const unsigned shift = 32*k;
+        masks[xppStructuralIndex::NEWLINE]    |= uint64_t(unsigned(_mm256_movemask_epi8(newline)))    << shift;
+        masks[xppStructuralIndex::COMMENT]    |= uint64_t(unsigned(_mm256_movemask_epi8(comment)))    << shift;
+        masks[xppStructuralIndex::BRACKET]    |= uint64_t(unsigned(_mm256_movemask_epi8(bracket)))    << shift;
+        masks[xppStructuralIndex::WHITESPACE] |= uint64_t(unsigned(_mm256_movemask_epi8(whitespace))) << shift;
+        masks[xppStructuralIndex::EQUALS]     |= uint64_t(unsigned(_mm256_movemask_epi8(equals)))     << shift;
+        masks[xppStructuralIndex::COMMA]      |= uint64_t(unsigned(_mm256_movemask_epi8(comma)))      << shift;
+    }
+}
+#endif
+
+} // namespace
+
+/**
+ * @brief xppStructuralIndex::xppStructuralIndex Builds the index with the best
+ * implementation available on the running CPU
+ * @param data Pointer to the buffer.
+ * @param size Number of bytes in the buffer.
+ */
+xppStructuralIndex::xppStructuralIndex(const char *data, std::size_t size) {
+    build(data, size, bestImplementation());
+}
+
+/**
+ * @brief xppStructuralIndex::xppStructuralIndex Builds the index with a given
+ * implementation. Unavailable implementations fall back to the scalar one.
+ * @param data Pointer to the buffer.
+ * @param size Number of bytes in the buffer.
+ * @param impl The implementation to be used.
+ */
+xppStructuralIndex::xppStructuralIndex(const char *data, std::size_t size,
+                                       implementation impl) {
+    build(data, size, impl);
+}
+
+/**
+ * @brief xppStructuralIndex::bestImplementation Determines the widest
+ * instruction set supported by the running CPU.
+ */
+xppStructuralIndex::implementation xppStructuralIndex::bestImplementation(void) {
+#ifdef XPP_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return AVX2;
+    }
+#endif
+#ifdef XPP_HAVE_SSE2
+    return SSE2;
+#else
+    return SCALAR;
+#endif
+}
+
+/**
+ * @brief xppStructuralIndex::next Finds the next character of a class
+ * @param cls The character class.
+ * @param pos The position from which the search starts.
+ * @param end The position after the searched range.
+ * @return The position of the next character of the class in [pos, end) or
+ * end if there is none.
+ */
+std::size_t xppStructuralIndex::next(characterClass cls, std::size_t pos,
+                                     std::size_t end) const {
+    if (pos >= end) {
+        return end;
+    }
+    const uint64_t *map = bits.data() + cls;
+    std::size_t word = pos >> 6;
+    uint64_t current = map[NUM_CLASSES*word] & (~uint64_t(0) << (pos & 63));
+    const std::size_t lastWord = (end-1) >> 6;
+    while (true) {
+        if (current) {
+            const std::size_t found = (word << 6) + countTrailingZeros(current);
+            return found < end ? found : end;
+        }
+        if (++word > lastWord) {
+            return end;
+        }
+        current = map[NUM_CLASSES*word];
+    }
+}
+
+/**
+ * @brief xppStructuralIndex::nextNot Finds the next character not in a class
+ * @param cls The character class.
+ * @param pos The position from which the search starts.
+ * @param end The position after the searched range.
+ * @return The position of the next character outside of the class in
+ * [pos, end) or end if there is none.
+ */
+std::size_t xppStructuralIndex::nextNot(characterClass cls, std::size_t pos,
+                                        std::size_t end) const {
+    if (pos >= end) {
+        return end;
+    }
+    const uint64_t *map = bits.data() + cls;
+    std::size_t word = pos >> 6;
+    uint64_t current = ~map[NUM_CLASSES*word] & (~uint64_t(0) << (pos & 63));
+    const std::size_t lastWord = (end-1) >> 6;
+    while (true) {
+        if (current) {
+            const std::size_t found = (word << 6) + countTrailingZeros(current);
+            return found < end ? found : end;
+        }
+        if (++word > lastWord) {
+            return end;
+        }
+        current = ~map[NUM_CLASSES*word];
+    }
+}
+
+/**
+ * @brief xppStructuralIndex::test Checks whether a character belongs to a class
+ * @param cls The character class.
+ * @param pos The position of the character.
+ */
+bool xppStructuralIndex::test(characterClass cls, std::size_t pos) const {
+    return (bits[NUM_CLASSES*(pos >> 6) + cls] >> (pos & 63)) & 1;
+}
+
+/**
+ * @brief xppStructuralIndex::build Classifies the buffer block by block
+ *
+ * The last incomplete block is copied into a zero padded buffer, so that the
+ * block classifiers never read past the end of the input.
+ */
+void xppStructuralIndex::build(const char *data, std::size_t size,
+                               implementation impl) {
+    void (*classify)(const char*, uint64_t*) = classifyScalar;
+#ifdef XPP_HAVE_SSE2
+    if (impl == SSE2) {
+        classify = classifySSE2;
+    }
+#endif
+#ifdef XPP_HAVE_AVX2
+    if (impl == AVX2 && __builtin_cpu_supports("avx2")) {
+        classify = classifyAVX2;
+    }
+#endif
+
+    const std::size_t numWords = (size + 63) / 64;
+    bits.assign(NUM_CLASSES*numWords, 0);
+    for (std::size_t word = 0; word < numWords; ++word) {
+        const std::size_t offset = 64*word;
+        uint64_t *masks = bits.data() + NUM_CLASSES*word;
+        if (offset + 64 <= size) {
+            classify(data + offset, masks);
+        } else {
+            char padded[64] = {0};
+            std::memcpy(padded, data + offset, size - offset);
+            classify(padded, masks);
+        }
+    }
+}
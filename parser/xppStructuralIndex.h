@@ -0,0 +1,55 @@
+#ifndef XPPSTRUCTURALINDEX_H
+#define XPPSTRUCTURALINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Bitmap index of the structural characters of an ode file. The buffer is
+ * classified once in blocks of 64 bytes, where bit i of word w corresponds to
+ * byte 64*w+i of the buffer. The later stages then jump from one set bit to
+ * the next instead of rescanning the characters. Depending on the CPU the
+ * blocks are classified with AVX2, SSE2 or a scalar loop, which all yield the
+ * same bitmaps. The words of all classes are interleaved in a single vector,
+ * so that the index of a short line costs a single allocation.
+ */
+class xppStructuralIndex {
+public:
+    /* The different classes of structural characters */
+    enum characterClass {
+        NEWLINE,	/**< '\n' */
+        COMMENT,	/**< '#' */
+        BRACKET,	/**< '(', ')', '[', ']', '{', '}' */
+        WHITESPACE,	/**< ' ', '\t', '\f', '\v', '\r' */
+        EQUALS,		/**< '=' */
+        COMMA,		/**< ',' */
+        NUM_CLASSES
+    };
+
+    /* The instruction set used to classify the blocks */
+    enum implementation {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+
+    xppStructuralIndex(const char *data, std::size_t size);
+    xppStructuralIndex(const char *data, std::size_t size, implementation impl);
+
+    std::size_t	next	(characterClass cls, std::size_t pos, std::size_t end) const;
+    std::size_t	nextNot	(characterClass cls, std::size_t pos, std::size_t end) const;
+    bool		test	(characterClass cls, std::size_t pos) const;
+
+    std::size_t	numWords(void) const {return bits.size() / NUM_CLASSES;}
+    uint64_t	word	(characterClass cls, std::size_t w) const {return bits[NUM_CLASSES*w + cls];}
+
+    static implementation bestImplementation(void);
+
+private:
+    void build(const char *data, std::size_t size, implementation impl);
+
+    /* The bitmaps of all classes, word w of class c is bits[NUM_CLASSES*w+c] */
+    std::vector<uint64_t> bits;
+};
+
+#endif // XPPSTRUCTURALINDEX_H
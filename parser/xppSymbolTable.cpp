@@ -0,0 +1,99 @@
+#include "xppSymbolTable.h"
+
+#include <algorithm>
+
+#include "xppHash.h"
+
+namespace {
+
+/* Number of slots of a newly used table */
+const std::size_t minCapacity = 64;
+
+} // namespace
+
+/**
+ * @brief xppSymbolTable::insert Registers a name
+ * @param name The name.
+ * @return The ID of the name and whether it was newly registered.
+ */
+std::pair<unsigned, bool> xppSymbolTable::insert(const std::string &name) {
+    if (2*(symbols.size()+1) > slots.size()) {
+        rehash(std::max(minCapacity, 2*slots.size()));
+    }
+    const uint64_t hash = xppHash(name);
+    const std::size_t mask = slots.size() - 1;
+    std::size_t slot = hash & mask;
+    for (; slots[slot] != noSymbol; slot = (slot + 1) & mask) {
+        const unsigned id = slots[slot];
+        if (hashes[id] == hash && symbols[id] == name) {
+            return std::make_pair(id, false);
+        }
+    }
+    const unsigned id = static_cast<unsigned>(symbols.size());
+    slots[slot] = id;
+    symbols.push_back(name);
+    hashes.push_back(hash);
+    return std::make_pair(id, true);
+}
+
+/**
+ * @brief xppSymbolTable::find Looks up a name
+ * @param name The name.
+ * @return The ID of the name or noSymbol if it is not registered.
+ */
+unsigned xppSymbolTable::find(const std::string &name) const {
+    if (symbols.empty()) {
+        return noSymbol;
+    }
+    const uint64_t hash = xppHash(name);
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t slot = hash & mask; slots[slot] != noSymbol;
+         slot = (slot + 1) & mask) {
+        const unsigned id = slots[slot];
+        if (hashes[id] == hash && symbols[id] == name) {
+            return id;
+        }
+    }
+    return noSymbol;
+}
+
+/**
+ * @brief xppSymbolTable::clear Removes all names
+ */
+void xppSymbolTable::clear(void) {
+    symbols.clear();
+    hashes.clear();
+    slots.assign(slots.size(), noSymbol);
+}
+
+/**
+ * @brief xppSymbolTable::reserve Prepares the table for a number of names
+ * @param count The expected number of names.
+ */
+void xppSymbolTable::reserve(std::size_t count) {
+    symbols.reserve(count);
+    hashes.reserve(count);
+    std::size_t capacity = std::max(minCapacity, slots.size());
+    while (capacity < 2*count) {
+        capacity *= 2;
+    }
+    if (capacity > slots.size()) {
+        rehash(capacity);
+    }
+}
+
+/**
+ * @brief xppSymbolTable::rehash Redistributes the names into a new table
+ * @param capacity The number of slots, a power of two.
+ */
+void xppSymbolTable::rehash(std::size_t capacity) {
+    slots.assign(capacity, noSymbol);
+    const std::size_t mask = capacity - 1;
+    for (unsigned id = 0; id < symbols.size(); ++id) {
+        std::size_t slot = hashes[id] & mask;
+        while (slots[slot] != noSymbol) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = id;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef XPPSYMBOLTABLE_H
+#define XPPSYMBOLTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xppParserDefines.h"
+
+/* Interned names of an ode file. Every name is stored once and identified by
+ * its symbol ID, which is the position of its registration. Names are found
+ * through an open addressing hash table with linear probing, so registering
+ * n names takes linear time and lookups do not allocate.
+ */
+class xppSymbolTable {
+public:
+    std::pair<unsigned, bool> insert (const std::string &name);
+    unsigned	find	(const std::string &name) const;
+    bool		contains(const std::string &name) const {return find(name) != noSymbol;}
+
+    const std::string &name	(unsigned id) const {return symbols[id];}
+    const stringList  &names(void) const {return symbols;}
+    std::size_t	size	(void) const {return symbols.size();}
+
+    void		clear	(void);
+    void		reserve	(std::size_t count);
+
+private:
+    void		rehash	(std::size_t capacity);
+
+    /* The names in the order of registration, indexed by their ID */
+    stringList				symbols;
+
+    /* Hashes of the names, which avoid string comparisons and rehashing */
+    std::vector<uint64_t>	hashes;
+
+    /* Slots of the hash table, which contain IDs or noSymbol if empty. The
+     * size is a power of two and at least twice the number of names.
+     */
+    std::vector<unsigned>	slots;
+};
+
+#endif // XPPSYMBOLTABLE_H
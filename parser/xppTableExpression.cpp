@@ -0,0 +1,345 @@
+#include "xppTableExpression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+/* Number of grid points that are evaluated together */
+const std::size_t blockSize = 256;
+
+/* Minimal number of grid points per thread */
+const std::size_t minPointsPerThread = 16384;
+
+} // namespace
+
+/**
+ * @brief xppTableExpression::xppTableExpression Compiles a table expression
+ *
+ * @param expr The defining expression of the table.
+ */
+xppTableExpression::xppTableExpression(const std::string &expr)
+    : text(expr)
+{
+    skipSpaces();
+    compiled = parseSum() && pos == text.size();
+    if (compiled) {
+        /* Determine the maximal stack depth for the evaluation */
+        std::size_t size = 0;
+        for (const instruction &instr : program) {
+            if (instr.op == PUSH_CONST || instr.op == PUSH_T) {
+                depth = std::max(depth, ++size);
+            } else if (instr.op != NEG && instr.op != CALL) {
+                --size;
+            }
+        }
+    } else {
+        program.clear();
+    }
+}
+
+/**
+ * @brief xppTableExpression::evaluate Evaluates the expression on a grid
+ * @param xLow The first grid point.
+ * @param dx The distance between two grid points.
+ * @param npoints The number of grid points.
+ * @param values The results for t = xLow + j*dx, j = 0, ..., npoints-1.
+ * @param threads The maximal number of threads.
+ * @return False if the expression is not compiled or any result is not finite.
+ * In the latter case muparserx might still return a complex number.
+ */
+bool xppTableExpression::evaluate(double xLow, double dx, std::size_t npoints,
+                                  std::vector<double> &values,
+                                  unsigned threads) const {
+    if (!compiled) {
+        return false;
+    }
+    values.resize(npoints);
+
+    threads = static_cast<unsigned>(std::max<std::size_t>(1,
+                std::min<std::size_t>(threads, npoints / minPointsPerThread)));
+    if (threads <= 1) {
+        return evaluateRange(xLow, dx, 0, npoints, values.data());
+    }
+
+    /* Every thread evaluates a contiguous range of whole blocks */
+    const std::size_t blocks = (npoints + blockSize - 1) / blockSize;
+    std::atomic<bool> finite(true);
+    auto worker = [&](unsigned i) {
+        const std::size_t first = std::min(npoints, blocks * i / threads * blockSize);
+        const std::size_t last  = std::min(npoints, blocks * (i+1) / threads * blockSize);
+        if (!evaluateRange(xLow, dx, first, last, values.data())) {
+            finite = false;
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads-1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+    return finite;
+}
+
+/**
+ * @brief xppTableExpression::evaluateRange Evaluates the grid points
+ * first, ..., last-1 block by block. Every instruction is applied to the whole
+ * block before the next one, so that the loops can be vectorized.
+ */
+bool xppTableExpression::evaluateRange(double xLow, double dx, std::size_t first,
+                                       std::size_t last, double *values) const {
+    std::vector<double> stack(depth * blockSize);
+    bool finite = true;
+    for (std::size_t begin = first; begin < last; begin += blockSize) {
+        const std::size_t n = std::min(blockSize, last - begin);
+        std::size_t top = 0;
+        for (const instruction &instr : program) {
+            double *a = &stack[(top > 0 ? top-1 : 0) * blockSize];
+            switch (instr.op) {
+            case PUSH_CONST:
+                a = &stack[top++ * blockSize];
+                std::fill(a, a + n, instr.value);
+                break;
+            case PUSH_T:
+                a = &stack[top++ * blockSize];
+                for (std::size_t k = 0; k < n; ++k) {
+                    a[k] = xLow + static_cast<double>(begin + k) * dx;
+                }
+                break;
+            case ADD:
+                a -= blockSize;
+                for (std::size_t k = 0; k < n; ++k) {a[k] += a[k + blockSize];}
+                --top;
+                break;
+            case SUB:
+                a -= blockSize;
+                for (std::size_t k = 0; k < n; ++k) {a[k] -= a[k + blockSize];}
+                --top;
+                break;
+            case MUL:
+                a -= blockSize;
+                for (std::size_t k = 0; k < n; ++k) {a[k] *= a[k + blockSize];}
+                --top;
+                break;
+            case DIV:
+                a -= blockSize;
+                for (std::size_t k = 0; k < n; ++k) {a[k] /= a[k + blockSize];}
+                --top;
+                break;
+            case POW:
+                a -= blockSize;
+                for (std::size_t k = 0; k < n; ++k) {a[k] = std::pow(a[k], a[k + blockSize]);}
+                --top;
+                break;
+            case NEG:
+                /* muparserx negates zero to +0 */
+                for (std::size_t k = 0; k < n; ++k) {a[k] = 0.0 - a[k];}
+                break;
+            case CALL:
+                switch (instr.fun) {
+                case SIN:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::sin(a[k]);}	break;
+                case COS:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::cos(a[k]);}	break;
+                case TAN:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::tan(a[k]);}	break;
+                case SINH:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::sinh(a[k]);}	break;
+                case COSH:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::cosh(a[k]);}	break;
+                case EXP:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::exp(a[k]);}	break;
+                case SQRT:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::sqrt(a[k]);}	break;
+                /* muparserx computes the absolute value as norm of a complex number */
+                case ABS:	for (std::size_t k = 0; k < n; ++k) {a[k] = std::sqrt(a[k]*a[k]);}	break;
+                default:	break;
+                }
+                break;
+            }
+        }
+
+        /* Results that are not finite are left to muparserx */
+        const double *result = stack.data();
+        for (std::size_t k = 0; k < n; ++k) {
+            finite &= std::isfinite(result[k]);
+            values[begin + k] = result[k];
+        }
+        if (!finite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief xppTableExpression::parseSum Parses a sum or difference of products
+ */
+bool xppTableExpression::parseSum(void) {
+    if (!parseProduct()) {
+        return false;
+    }
+    while (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        const opcode op = text[pos++] == '+' ? ADD : SUB;
+        skipSpaces();
+        if (!parseProduct()) {
+            return false;
+        }
+        program.push_back(instruction{op, SIN, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppTableExpression::parseProduct Parses a product or quotient
+ */
+bool xppTableExpression::parseProduct(void) {
+    if (!parseUnary()) {
+        return false;
+    }
+    while (pos < text.size() && (text[pos] == '*' || text[pos] == '/')) {
+        const opcode op = text[pos++] == '*' ? MUL : DIV;
+        skipSpaces();
+        if (!parseUnary()) {
+            return false;
+        }
+        program.push_back(instruction{op, SIN, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppTableExpression::parseUnary Parses a signed power. As in
+ * muparserx the sign binds weaker than the power, so -t^2 is -(t^2).
+ *
+ * muparserx rejects a sign that follows another sign and a leading '+' unless
+ * it belongs to a number, and reads signed numbers differently, e.g. --2^2 as
+ * -((-2)^2). Such expressions are not compiled, so that muparserx decides.
+ */
+bool xppTableExpression::parseUnary(void) {
+    if (pos < text.size() && text[pos] == '+') {
+        return false;
+    }
+    if (pos < text.size() && text[pos] == '-') {
+        ++pos;
+        skipSpaces();
+        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+            return false;
+        }
+        if (!parsePower()) {
+            return false;
+        }
+        program.push_back(instruction{NEG, SIN, 0.0});
+        return true;
+    }
+    return parsePower();
+}
+
+/**
+ * @brief xppTableExpression::parsePower Parses a right associative power
+ */
+bool xppTableExpression::parsePower(void) {
+    if (!parseAtom()) {
+        return false;
+    }
+    if (pos < text.size() && text[pos] == '^') {
+        ++pos;
+        skipSpaces();
+        if (!parseUnary()) {
+            return false;
+        }
+        program.push_back(instruction{POW, SIN, 0.0});
+    }
+    return true;
+}
+
+/**
+ * @brief xppTableExpression::parseAtom Parses a number, t, a constant, a
+ * function call or an expression in parentheses
+ */
+bool xppTableExpression::parseAtom(void) {
+    if (pos >= text.size()) {
+        return false;
+    }
+    const char c = text[pos];
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+        const std::size_t begin = pos;
+        while (pos < text.size() &&
+               (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) {
+            ++pos;
+        }
+        const std::string name = text.substr(begin, pos - begin);
+        skipSpaces();
+        if (pos < text.size() && text[pos] == '(') {
+            if (!parseCall(name)) {
+                return false;
+            }
+        } else if (name == "t") {
+            program.push_back(instruction{PUSH_T, SIN, 0.0});
+        } else if (name == "pi") {
+            program.push_back(instruction{PUSH_CONST, SIN, 3.141592653589793238462643});
+        } else if (name == "e") {
+            program.push_back(instruction{PUSH_CONST, SIN, 2.718281828459045235360287});
+        } else {
+            return false;
+        }
+    } else if (c == '(') {
+        ++pos;
+        skipSpaces();
+        if (!parseSum() || pos >= text.size() || text[pos] != ')') {
+            return false;
+        }
+        ++pos;
+    } else if ((std::isdigit(static_cast<unsigned char>(c)) || c == '.') &&
+               text.compare(pos, 2, "0x") != 0 && text.compare(pos, 2, "0X") != 0) {
+        const char *begin = text.c_str() + pos;
+        char *end;
+        const double value = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        pos += end - begin;
+        program.push_back(instruction{PUSH_CONST, SIN, value});
+    } else {
+        return false;
+    }
+    skipSpaces();
+    return true;
+}
+
+/**
+ * @brief xppTableExpression::parseCall Parses the argument of a function call
+ * @param name The name of the function, the position is at the opening bracket
+ */
+bool xppTableExpression::parseCall(const std::string &name) {
+    static const struct {
+        const char	*name;
+        function	fun;
+    } functions[] = {
+        {"sin", SIN}, {"cos", COS}, {"tan", TAN}, {"sinh", SINH},
+        {"cosh", COSH}, {"exp", EXP}, {"sqrt", SQRT}, {"abs", ABS}
+    };
+    for (const auto &entry : functions) {
+        if (name != entry.name) {
+            continue;
+        }
+        ++pos;
+        skipSpaces();
+        if (!parseSum() || pos >= text.size() || text[pos] != ')') {
+            return false;
+        }
+        ++pos;
+        program.push_back(instruction{CALL, entry.fun, 0.0});
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief xppTableExpression::skipSpaces Advances past whitespaces
+ */
+void xppTableExpression::skipSpaces(void) {
+    while (pos < text.size() && text[pos] == ' ') {
+        ++pos;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef XPPTABLEEXPRESSION_H
+#define XPPTABLEEXPRESSION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/* Defining expression of a computed table, e.g. "sin(t)^2", in the variable t.
+ * The expression is compiled once into a stack program that is evaluated
+ * instruction by instruction over blocks of grid points, so every instruction
+ * is a tight loop over contiguous doubles instead of a boxed evaluation per
+ * point. Large tables are split into ranges that are evaluated on several
+ * threads.
+ *
+ * The arithmetic follows muparserx for real arguments: the operators +, -, *,
+ * / and the right associative ^, the constants pi and e and the common
+ * elementary functions, with bitwise identical results. Expressions that use
+ * anything else, e.g. comparisons, units or signs muparserx reads differently
+ * like --t or +t, are not compiled and have to be evaluated by muparserx
+ * instead.
+ */
+class xppTableExpression {
+public:
+    explicit xppTableExpression(const std::string &expr);
+
+    bool	isCompiled	(void) const {return compiled;}
+
+    bool	evaluate	(double xLow, double dx, std::size_t npoints,
+                         std::vector<double> &values, unsigned threads = 1) const;
+
+private:
+    /* Instructions of the stack program */
+    enum opcode {
+        PUSH_CONST,
+        PUSH_T,
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        POW,
+        NEG,
+        CALL
+    };
+
+    /* Functions of muparserx that evaluate real arguments in real arithmetic.
+     * The others, e.g. log, are evaluated in complex arithmetic and would not
+     * give the same results.
+     */
+    enum function {
+        SIN,
+        COS,
+        TAN,
+        SINH,
+        COSH,
+        EXP,
+        SQRT,
+        ABS
+    };
+
+    struct instruction {
+        opcode		op;
+        function	fun;
+        double		value;
+    };
+
+    bool parseSum		(void);
+    bool parseProduct	(void);
+    bool parseUnary		(void);
+    bool parsePower		(void);
+    bool parseAtom		(void);
+    bool parseCall		(const std::string &name);
+    void skipSpaces		(void);
+
+    bool evaluateRange	(double xLow, double dx, std::size_t first,
+                         std::size_t last, double *values) const;
+
+    /* The compiled expression and the current parsing position */
+    const std::string			text;
+    std::size_t					pos		 = 0;
+
+    /* The stack program in postfix order */
+    std::vector<instruction>	program;
+
+    /* Maximal depth of the stack during evaluation */
+    std::size_t					depth	 = 0;
+
+    /* Flag whether the expression could be compiled */
+    bool						compiled = false;
+};
+
+#endif // XPPTABLEEXPRESSION_H
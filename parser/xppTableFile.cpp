@@ -0,0 +1,109 @@
+#include "xppTableFile.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+/* Identification of binary table files */
+const char tableMagic[8] = {'X', 'P', 'P', 'T', 'A', 'B', 'L', 'E'};
+
+/* Size of the header: magic, number of points and both bounds */
+const std::size_t headerSize = sizeof(tableMagic) + sizeof(uint64_t) +
+                               2*sizeof(double);
+
+} // namespace
+
+/**
+ * @brief xppTableFile::isBinary Checks whether a table file is binary
+ * @param data Pointer to the file content.
+ * @param size Number of bytes of the file content.
+ */
+bool xppTableFile::isBinary(const char *data, std::size_t size) {
+    return size >= sizeof(tableMagic) &&
+           std::memcmp(data, tableMagic, sizeof(tableMagic)) == 0;
+}
+
+/**
+ * @brief xppTableFile::readBinary Reads a binary table file
+ * @param data Pointer to the file content.
+ * @param size Number of bytes of the file content.
+ * @param table The resulting table.
+ * @return False if the file is truncated or malformed.
+ */
+bool xppTableFile::readBinary(const char *data, std::size_t size,
+                              xppTable &table) {
+    if (!isBinary(data, size) || size < headerSize) {
+        return false;
+    }
+    const char *pos = data + sizeof(tableMagic);
+    uint64_t npoints;
+    std::memcpy(&npoints, pos, sizeof(npoints));
+    pos += sizeof(npoints);
+    std::memcpy(&table.xLow, pos, sizeof(double));
+    pos += sizeof(double);
+    std::memcpy(&table.xHigh, pos, sizeof(double));
+    pos += sizeof(double);
+
+    if (npoints != (size - headerSize) / sizeof(double) ||
+        (size - headerSize) % sizeof(double) != 0) {
+        return false;
+    }
+    table.values.resize(npoints);
+    if (npoints > 0) {
+        std::memcpy(table.values.data(), pos, npoints*sizeof(double));
+    }
+    return true;
+}
+
+/**
+ * @brief xppTableFile::writeBinary Writes a table in the binary format
+ * @param fn The name of the file.
+ * @param table The table to be written.
+ * @return False if the file could not be written.
+ */
+bool xppTableFile::writeBinary(const std::string &fn, const xppTable &table) {
+    std::ofstream tableStream(fn.c_str(), std::ios::out | std::ios::binary);
+    const uint64_t npoints = table.values.size();
+    tableStream.write(tableMagic, sizeof(tableMagic));
+    tableStream.write(reinterpret_cast<const char*>(&npoints), sizeof(npoints));
+    tableStream.write(reinterpret_cast<const char*>(&table.xLow), sizeof(double));
+    tableStream.write(reinterpret_cast<const char*>(&table.xHigh), sizeof(double));
+    tableStream.write(reinterpret_cast<const char*>(table.values.data()),
+                      npoints*sizeof(double));
+    return static_cast<bool>(tableStream);
+}
+
+/**
+ * @brief xppTableFile::parseNumber Parses a plain floating point number
+ * @param begin Pointer to the first character of the number.
+ * @param end Pointer past the last character of the number.
+ * @param value The resulting number.
+ * @return False if the range is not exactly one number, e.g. an expression.
+ *
+ * The range does not have to be null terminated, so that numbers can be read
+ * directly out of a memory mapping. Numbers are correctly rounded.
+ */
+bool xppTableFile::parseNumber(const char *begin, const char *end,
+                               double &value) {
+    char buffer[64];
+    const std::size_t length = static_cast<std::size_t>(end - begin);
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    /* Only accept decimal numbers as xppaut does */
+    for (std::size_t i = 0; i < length; ++i) {
+        const char c = buffer[i];
+        if (!((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' ||
+              c == '+' || c == '-')) {
+            return false;
+        }
+    }
+    char *stop;
+    value = std::strtod(buffer, &stop);
+    return stop == buffer + length;
+}
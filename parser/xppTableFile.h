@@ -0,0 +1,32 @@
+#ifndef XPPTABLEFILE_H
+#define XPPTABLEFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Sampled function of a table statement on an equidistant grid */
+struct xppTable {
+    double				xLow	= 0.0;
+    double				xHigh	= 0.0;
+    std::vector<double>	values;
+};
+
+/* Helpers for table files. Besides the text format of xppaut, where the
+ * number of points, the bounds and the values are given one per line, tables
+ * can be stored in a binary format. It consists of the magic "XPPTABLE", the
+ * number of points as 64 bit integer, the lower and upper bound and the
+ * values, all as doubles in native byte order. Binary tables are read with a
+ * single copy out of a memory mapping.
+ */
+class xppTableFile {
+public:
+    static bool isBinary	(const char *data, std::size_t size);
+    static bool readBinary	(const char *data, std::size_t size, xppTable &table);
+    static bool writeBinary	(const std::string &fn, const xppTable &table);
+
+    static bool parseNumber	(const char *begin, const char *end, double &value);
+};
+
+#endif // XPPTABLEFILE_H
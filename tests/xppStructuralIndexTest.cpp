@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parser/xppStructuralIndex.h"
+
+namespace {
+
+/* Characters of every class, in the order of xppStructuralIndex::characterClass */
+const char *const classCharacters[xppStructuralIndex::NUM_CLASSES] = {
+    "\n",
+    "#",
+    "()[]{}",
+    " \t\f\v\r",
+    "=",
+    ","
+};
+
+/**
+ * @brief matches Compares an index with the characters of its buffer
+ * @param index The index of the buffer.
+ * @param data Pointer to the buffer.
+ * @param size Number of bytes in the buffer.
+ * @return False if a bit differs from its character or the padding is set
+ */
+bool matches(const xppStructuralIndex &index, const char *data, std::size_t size) {
+    if (index.numWords() != (size + 63) / 64) {
+        return false;
+    }
+    for (int cls = 0; cls < xppStructuralIndex::NUM_CLASSES; ++cls) {
+        const xppStructuralIndex::characterClass c =
+                static_cast<xppStructuralIndex::characterClass>(cls);
+        for (std::size_t pos = 0; pos < 64*index.numWords(); ++pos) {
+            const bool expected = pos < size && data[pos] != '\0' &&
+                                  std::strchr(classCharacters[cls], data[pos]);
+            if (index.test(c, pos) != expected) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief findsAll Compares next and nextNot with a plain scan of the buffer
+ * @param index The index of the buffer.
+ * @param data Pointer to the buffer.
+ * @param size Number of bytes in the buffer.
+ */
+bool findsAll(const xppStructuralIndex &index, const char *data, std::size_t size) {
+    for (int cls = 0; cls < xppStructuralIndex::NUM_CLASSES; ++cls) {
+        const xppStructuralIndex::characterClass c =
+                static_cast<xppStructuralIndex::characterClass>(cls);
+        std::size_t expected = size, expectedNot = size;
+        for (std::size_t pos = size; pos-- > 0;) {
+            if (data[pos] != '\0' && std::strchr(classCharacters[cls], data[pos])) {
+                expected = pos;
+            } else {
+                expectedNot = pos;
+            }
+            if (index.next(c, pos, size) != expected ||
+                index.nextNot(c, pos, size) != expectedNot) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+/* Compares the bitmaps of the SSE2 and AVX2 classifiers of xppStructuralIndex
+ * with the scalar one and all of them with the characters of random buffers.
+ * The buffers favour the structural characters, the other whitespace bytes
+ * 9-13 and bytes with the high bit set. Their lengths and alignments are
+ * random, so that most of them end in a partial block. Implementations the
+ * CPU does not support fall back to the scalar classifier.
+ */
+int main(int argc, char** argv)
+{
+    const unsigned buffers = argc > 1 ? std::stoul(argv[1]) : 2000;
+    static const char special[] = "\t\n\v\f\r #()[]{}=,";
+    std::mt19937 random(2017);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<std::size_t> length(0, 1000);
+    std::uniform_int_distribution<std::size_t> offset(0, 63);
+    std::uniform_int_distribution<std::size_t> pick(0, sizeof(special) - 2);
+
+    unsigned failed = 0;
+    std::vector<char> buffer;
+    for (unsigned i = 0; i < buffers; ++i) {
+        const std::size_t first = offset(random);
+        const std::size_t size = length(random);
+        buffer.resize(first + size);
+        for (std::size_t j = first; j < buffer.size(); ++j) {
+            const int value = byte(random);
+            if (value < 96) {
+                buffer[j] = special[pick(random)];
+            } else if (value < 160) {
+                buffer[j] = static_cast<char>(0x80 | value);
+            } else {
+                buffer[j] = static_cast<char>(value % 128);
+            }
+        }
+
+        const char *data = buffer.data() + first;
+        const xppStructuralIndex scalar(data, size, xppStructuralIndex::SCALAR);
+        const xppStructuralIndex sse2(data, size, xppStructuralIndex::SSE2);
+        const xppStructuralIndex avx2(data, size, xppStructuralIndex::AVX2);
+        if (!matches(scalar, data, size) || !matches(sse2, data, size) ||
+            !matches(avx2, data, size) || !findsAll(scalar, data, size)) {
+            std::cerr << "Structural index differs for buffer " << i
+                      << " with " << size << " bytes" << std::endl;
+            ++failed;
+        }
+    }
+    std::cout << "Compared " << buffers << " buffers, " << failed
+              << " differ" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -2,14 +2,28 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 include(parser/muparserx/muparserx.pri)
 
-HEADERS +=	parser/keywordTrie.hpp \
+HEADERS +=	parser/compactTrie.hpp \
+		parser/keywordTrie.hpp \
+		parser/xppCompactModel.h \
 		parser/xppEvaluator.h \
+		parser/xppHash.h \
+		parser/xppIndexExpression.h \
+		parser/xppLineText.h \
+		parser/xppMappedFile.h \
+		parser/xppModelCache.h \
 		parser/xppParser.h \
 		parser/xppParserDefines.h \
 		parser/xppParserException.h \
+		parser/xppParserStats.h \
+		parser/xppPerfectHash.h \
+		parser/xppStructuralIndex.h \
+		parser/xppSymbolTable.h \
+		parser/xppTableExpression.h \
+		parser/xppTableFile.h \
 		settings/xppAutoSettings.h \
 		settings/xppMainSettings.h \
 		settings/xppSettings.h \
@@ -18,14 +32,33 @@ HEADERS +=	parser/keywordTrie.hpp \
 		xppPlots.h
 
 SOURCES +=	main.cpp \
+		parser/xppCompactModel.cpp \
 		parser/xppEvaluator.cpp \
+		parser/xppIndexExpression.cpp \
+		parser/xppLineText.cpp \
+		parser/xppMappedFile.cpp \
+		parser/xppModelCache.cpp \
 		parser/xppParser.cpp \
+		parser/xppParserStats.cpp \
+		parser/xppStructuralIndex.cpp \
+		parser/xppSymbolTable.cpp \
+		parser/xppTableExpression.cpp \
+		parser/xppTableFile.cpp \
 		settings/xppSettings.cpp
 
 PRECOMPILED_HEADER +=
 
-QMAKE_CXXFLAGS += -std=c++11
+QMAKE_CXXFLAGS += -std=c++14
 QMAKE_CXXFLAGS_RELEASE -= -O1
 QMAKE_CXXFLAGS_RELEASE -= -O2
 QMAKE_CXXFLAGS_RELEASE *= -O3
 
+# Compare the SIMD classifiers of the structural index with the scalar one on
+# random buffers after every build. A difference fails the build.
+structuralIndexTest.target = check_structural_index
+structuralIndexTest.commands = $(CXX) $(CXXFLAGS) -I$$PWD -o xppStructuralIndexTest \
+		$$PWD/tests/xppStructuralIndexTest.cpp \
+		$$PWD/parser/xppStructuralIndex.cpp && \
+		./xppStructuralIndexTest
+first.depends = $(first) check_structural_index
+QMAKE_EXTRA_TARGETS += first structuralIndexTest